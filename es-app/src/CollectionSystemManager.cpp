@@ -288,7 +288,7 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 			// we didn't find it here - we need to check if we should add it
 			if (name == "recent" && file->metadata.get("playcount") > "0" && includeFileInAutoCollections(file) ||
 				name == "favorites" && file->metadata.get("favorite") == "true") {
-				CollectionFileData* newGame = new CollectionFileData(file, curSys);
+				CollectionFileData* newGame = new (curSys) CollectionFileData(file, curSys);
 				rootFolder->addChild(newGame);
 				curSys->addToIndex(newGame);
 				
@@ -515,7 +515,7 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file)
 			else
 			{
 				// we didn't find it here, we should add it
-				CollectionFileData* newGame = new CollectionFileData(file, sysData);
+				CollectionFileData* newGame = new (sysData) CollectionFileData(file, sysData);
 				rootFolder->addChild(newGame);
 				sysData->addToIndex(newGame);
 				ViewController::get()->getGameListView(systemViewToUpdate)->onFileChanged(newGame, FILE_METADATA_CHANGED);
@@ -742,26 +742,27 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 		// we won't iterate all collections
 		if ((*sysIt)->isGameSystem() && !(*sysIt)->isCollection()) 
 		{
-			std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
-			for(auto gameIt = files.cbegin(); gameIt != files.cend(); gameIt++)
+			(*sysIt)->getRootFolder()->forEachFile(GAME, false, [this, &sysDecl, newSys, rootFolder](FileData* game)
 			{
-				bool include = includeFileInAutoCollections((*gameIt));
+				bool include = includeFileInAutoCollections(game);
 				switch(sysDecl.type) {
 					case AUTO_LAST_PLAYED:
-						include = include && (*gameIt)->metadata.get("playcount") > "0";
+						include = include && game->metadata.get("playcount") > "0";
 						break;
 					case AUTO_FAVORITES:
 						// we may still want to add files we don't want in auto collections in "favorites"
-						include = (*gameIt)->metadata.get("favorite") == "true";
+						include = game->metadata.get("favorite") == "true";
 						break;
 				}
 
 				if (include) {
-					CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
+					CollectionFileData* newGame = new (newSys) CollectionFileData(game, newSys);
 					rootFolder->addChild(newGame);
 					newSys->addToIndex(newGame);
 				}
-			}
+
+				return true;
+			});
 		}
 	}
 	rootFolder->sort(getSortTypeFromString(sysDecl.defaultSort));
@@ -808,7 +809,7 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 		std::unordered_map<std::string, FileData*>::const_iterator it = pMap->find(gameKey);
 		if (it != pMap->cend())
 		{
-			CollectionFileData* newGame = new CollectionFileData(it->second, newSys);
+			CollectionFileData* newGame = new (newSys) CollectionFileData(it->second, newSys);
 			rootFolder->addChild(newGame);
 			newSys->addToIndex(newGame);
 		}
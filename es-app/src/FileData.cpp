@@ -9,24 +9,146 @@
 #include "FileSorts.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "PersistenceManager.h"
 #include "platform.h"
+#include "Profiler.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
 #include "Window.h"
 #include "views/UIModeController.h"
 #include <assert.h>
+#include <mutex>
+
+// Nodes are allocated in blocks of slots, one size class per size rounded to the granularity.
+// Each slot starts with the pool it belongs to, nullptr for the nodes allocated on the heap.
+#define NODE_POOL_GRANULARITY	16
+#define NODE_POOL_MAX_SIZE		512
+#define NODE_POOL_BLOCK_SLOTS	256
+#define NODE_POOL_HEADER_SIZE	NODE_POOL_GRANULARITY
+
+std::atomic<unsigned int> FolderData::sDisplayVersion(1);
+
+FileDataPool::FileDataPool() : mSizes(NODE_POOL_MAX_SIZE / NODE_POOL_GRANULARITY), mLiveSlots(0), mReleased(false)
+{
+}
+
+FileDataPool::~FileDataPool()
+{
+	for (auto block : mBlocks)
+		::operator delete(block);
+}
+
+void* FileDataPool::allocate(size_t size)
+{
+	size_t slots = (size + NODE_POOL_HEADER_SIZE + NODE_POOL_GRANULARITY - 1) / NODE_POOL_GRANULARITY;
+	size_t slotSize = slots * NODE_POOL_GRANULARITY;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	SizeClass& sizeClass = mSizes[slots - 1];
+	char* slot;
+
+	if (sizeClass.freeSlots != nullptr)
+	{
+		slot = (char*)sizeClass.freeSlots;
+		sizeClass.freeSlots = *(void**)slot;
+	}
+	else
+	{
+		if (sizeClass.block == nullptr || sizeClass.blockUsed == NODE_POOL_BLOCK_SLOTS)
+		{
+			sizeClass.block = (char*)::operator new(slotSize * NODE_POOL_BLOCK_SLOTS);
+			sizeClass.blockUsed = 0;
+			mBlocks.push_back(sizeClass.block);
+		}
+
+		slot = sizeClass.block + slotSize * sizeClass.blockUsed++;
+	}
+
+	mLiveSlots++;
+
+	*(FileDataPool**)slot = this;
+	*(size_t*)(slot + sizeof(FileDataPool*)) = slots;
+
+	return slot + NODE_POOL_HEADER_SIZE;
+}
+
+void FileDataPool::deallocate(void* ptr)
+{
+	char* slot = (char*)ptr - NODE_POOL_HEADER_SIZE;
+
+	FileDataPool* pool = *(FileDataPool**)slot;
+	if (pool == nullptr)
+		::operator delete(slot);
+	else
+		pool->freeSlot(slot, *(size_t*)(slot + sizeof(FileDataPool*)));
+}
+
+void FileDataPool::freeSlot(void* slot, size_t slots)
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		SizeClass& sizeClass = mSizes[slots - 1];
+		*(void**)slot = sizeClass.freeSlots;
+		sizeClass.freeSlots = slot;
+
+		if (--mLiveSlots > 0 || !mReleased)
+			return;
+	}
+
+	// a node deleted after its system (i.e. a view placeholder) was the last one
+	delete this;
+}
+
+void FileDataPool::release()
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		mReleased = true;
+		if (mLiveSlots > 0)
+			return;
+	}
+
+	delete this;
+}
+
+void* FileData::operator new(size_t size, SystemData* system)
+{
+	if (system != nullptr && size + NODE_POOL_HEADER_SIZE <= NODE_POOL_MAX_SIZE)
+		return system->getNodePool()->allocate(size);
+
+	char* slot = (char*)::operator new(size + NODE_POOL_HEADER_SIZE);
+	*(FileDataPool**)slot = nullptr;
+
+	return slot + NODE_POOL_HEADER_SIZE;
+}
+
+void FileData::operator delete(void* ptr, SystemData* system)
+{
+	FileDataPool::deallocate(ptr);
+}
+
+void FileData::operator delete(void* ptr)
+{
+	if (ptr != nullptr)
+		FileDataPool::deallocate(ptr);
+}
 
 FileData::FileData(FileType type, const std::string& path, SystemData* system)
 	: mType(type), mSystem(system), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
+	metadata.setOwner(this);
+
 	mPath = Utils::FileSystem::createRelativePath(path, getSystemEnvData()->mStartPath, false);
 	
 //	TRACE("FileData : " << mPath);
 
 	// metadata needs at least a name field (since that's what getName() will return)
-	if (metadata.get("name").empty())
-		metadata.set("name", getDisplayName());	
+	if (metadata.getName().empty())
+		metadata.set(MetaDataId::Name, getDisplayName());	
 	
 	metadata.resetChangedFlag();
 }
@@ -74,12 +196,12 @@ std::string FileData::getCleanName() const
 
 const std::string FileData::getThumbnailPath() const
 {
-	std::string thumbnail = metadata.get("thumbnail");
+	std::string thumbnail = metadata.get(MetaDataId::Thumbnail);
 
 	// no thumbnail, try image
 	if(thumbnail.empty())
 	{
-		thumbnail = metadata.get("image");
+		thumbnail = metadata.get(MetaDataId::Image);
 		
 		// no image, try to use local image
 		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -102,17 +224,17 @@ const std::string FileData::getThumbnailPath() const
 
 const bool FileData::getFavorite()
 {
-	return metadata.get("favorite") == "true";
+	return metadata.getBool(MetaDataId::Favorite);
 }
 
 const bool FileData::getHidden()
 {
-	return metadata.get("hidden") == "true";
+	return metadata.getBool(MetaDataId::Hidden);
 }
 
 const bool FileData::getKidGame()
 {
-	return metadata.get("kidgame") != "false";
+	return metadata.get(MetaDataId::KidGame) != "false";
 }
 
 const std::string FileData::getName()
@@ -122,17 +244,17 @@ const std::string FileData::getName()
 
 const std::string FileData::getCore() const
 {
-	return metadata.get("core");	
+	return metadata.get(MetaDataId::Core);	
 }
 
 const std::string FileData::getEmulator() const
 {
-	return metadata.get("emulator");
+	return metadata.get(MetaDataId::Emulator);
 }
 
 const std::string FileData::getVideoPath() const
 {
-	std::string video = metadata.get("video");
+	std::string video = metadata.get(MetaDataId::Video);
 	
 	// no video, try to use local video
 	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -147,7 +269,7 @@ const std::string FileData::getVideoPath() const
 
 const std::string FileData::getMarqueePath() const
 {
-	std::string marquee = metadata.get("marquee");
+	std::string marquee = metadata.get(MetaDataId::Marquee);
 
 	// no marquee, try to use local marquee
 	if (marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -169,7 +291,7 @@ const std::string FileData::getMarqueePath() const
 
 const std::string FileData::getImagePath() const
 {
-	std::string image = metadata.get("image");
+	std::string image = metadata.get(MetaDataId::Image);
 
 	// no image, try to use local image
 	if(image.empty())
@@ -252,6 +374,9 @@ void FileData::launchGame(Window* window)
 
 	LOG(LogInfo) << "	" << command;
 
+	// The main loop doesn't run during the game, and the machine may be powered off before it ends
+	PersistenceManager::getInstance()->flush();
+
 	int exitCode = runSystemCommand(command, getDisplayName(), hideWindow ? NULL : window);
 	if (exitCode != 0)
 	{
@@ -271,11 +396,11 @@ void FileData::launchGame(Window* window)
 	{
 		FileData* gameToUpdate = getSourceFileData();
 
-		int timesPlayed = gameToUpdate->metadata.getInt("playcount") + 1;
-		gameToUpdate->metadata.set("playcount", std::to_string(static_cast<long long>(timesPlayed)));
+		int timesPlayed = gameToUpdate->metadata.getInt(MetaDataId::PlayCount) + 1;
+		gameToUpdate->metadata.setInt(MetaDataId::PlayCount, timesPlayed);
 
 		//update last played time
-		gameToUpdate->metadata.set("lastplayed", Utils::Time::DateTime(Utils::Time::now()));
+		gameToUpdate->metadata.set(MetaDataId::LastPlayed, Utils::Time::DateTime(Utils::Time::now()));
 		CollectionSystemManager::get()->refreshCollectionSystems(gameToUpdate);
 	}
 
@@ -334,7 +459,7 @@ void CollectionFileData::refreshMetadata()
 const std::string CollectionFileData::getName()
 {
 	if (mDirty) {
-		mCollectionFileName = Utils::String::removeParenthesis(mSourceFileData->metadata.get("name"));
+		mCollectionFileName = Utils::String::removeParenthesis(mSourceFileData->metadata.getName());
 		mCollectionFileName += " [" + Utils::String::toUpper(mSourceFileData->getSystem()->getName()) + "]";
 		mDirty = false;
 	}
@@ -342,7 +467,7 @@ const std::string CollectionFileData::getName()
 	if (Settings::getInstance()->getBool("CollectionShowSystemInfo"))
 		return mCollectionFileName;
 		
-	return Utils::String::removeParenthesis(mSourceFileData->metadata.get("name"));
+	return Utils::String::removeParenthesis(mSourceFileData->metadata.getName());
 }
 
 // returns Sort Type based on a string description
@@ -382,10 +507,24 @@ FileData* FolderData::findUniqueGameForFolder()
 	return NULL;
 }
 
-const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+void FileData::onMetadataChanged()
+{
+	if (mParent != nullptr)
+		mParent->invalidateDisplayedChildren();
+}
+
+unsigned long long FolderData::getDisplayVersion() const
+{
+	return ((unsigned long long)sDisplayVersion << 32) | mDisplayVersion;
+}
+
+void FolderData::invalidateDisplayedLists()
 {
-	std::vector<FileData*> ret;
+	sDisplayVersion++;
+}
 
+const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+{
 	bool flatFolders = Settings::getInstance()->getBool("FlatFolders");
 	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles");
 	bool filterKidGame = false;
@@ -405,6 +544,22 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 	if (idx != nullptr && !idx->isFiltered())
 		idx = nullptr;
 
+	DisplayState state;
+	state.version = getDisplayVersion();
+	state.index = idx;
+	state.sortId = flatFolders ? sys->getSortId() : 0;
+	state.flatFolders = flatFolders;
+	state.showHiddenFiles = showHiddenFiles;
+	state.filterKidGame = filterKidGame;
+
+	if (state == mDisplayedState)
+		return mDisplayedChildren;
+
+	PROFILE_SCOPE("FolderData::getChildrenListToDisplay");
+
+	std::vector<FileData*>& ret = mDisplayedChildren;
+	ret.clear();
+
 	std::vector<FileData*>* items = &mChildren;
 
 	std::vector<FileData*> flatGameList;
@@ -428,11 +583,14 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		ret.push_back(*it);
 	}
 
+	mDisplayedState = state;
 	return ret;
 }
 
 std::vector<FileData*> FolderData::getFlatGameList(bool displayedOnly, SystemData* system) const
 {
+	PROFILE_SCOPE("FolderData::getFlatGameList");
+
 	std::vector<FileData*> ret = getFilesRecursive(GAME, displayedOnly, system);
 
 	unsigned int currentSortId = system->getSortId();
@@ -441,10 +599,7 @@ std::vector<FileData*> FolderData::getFlatGameList(bool displayedOnly, SystemDat
 
 	auto sort = FileSorts::SortTypes.at(currentSortId);
 
-	std::stable_sort(ret.begin(), ret.end(), sort.comparisonFunction);
-
-	if (!sort.ascending)
-		std::reverse(ret.begin(), ret.end());
+	FileSorts::sortFiles(ret, sort);
 
 	return ret;
 }
@@ -453,28 +608,48 @@ std::vector<FileData*> FolderData::getFilesRecursive(unsigned int typeMask, bool
 {
 	std::vector<FileData*> out;
 
-	FileFilterIndex* idx = (system != nullptr ? system : mSystem)->getIndex(false);
+	// Filled in a single vector, the game count is known beforehand
+	if (typeMask == GAME)
+		out.reserve(mGameCount);
+
+	forEachFile(typeMask, displayedOnly, [&out](FileData* file) { out.push_back(file); return true; }, system);
+
+	return out;
+}
+
+bool FolderData::forEachFile(unsigned int typeMask, bool displayedOnly, const std::function<bool(FileData*)>& function, SystemData* system) const
+{
+	FileFilterIndex* idx = nullptr;
+
+	if (displayedOnly)
+	{
+		idx = (system != nullptr ? system : mSystem)->getIndex(false);
+		if (idx != nullptr && !idx->isFiltered())
+			idx = nullptr;
+	}
+
+	return forEachFile(typeMask, idx, function);
+}
 
+bool FolderData::forEachFile(unsigned int typeMask, FileFilterIndex* idx, const std::function<bool(FileData*)>& function) const
+{
 	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
-		if ((*it)->getType() & typeMask)
+		if (((*it)->getType() & typeMask) && (idx == nullptr || idx->showFile(*it)))
 		{
-			if (!displayedOnly || idx == nullptr || !idx->isFiltered() || idx->showFile(*it))
-				out.push_back(*it);
+			if (!function(*it))
+				return false;
 		}
 
 		if ((*it)->getType() != FOLDER)
 			continue;
 
 		FolderData* folder = (FolderData*)(*it);
-		if (folder->getChildren().size() > 0)
-		{
-			std::vector<FileData*> subchildren = folder->getFilesRecursive(typeMask, displayedOnly, system);
-			out.insert(out.cend(), subchildren.cbegin(), subchildren.cend());
-		}
+		if (!folder->mChildren.empty() && !folder->forEachFile(typeMask, idx, function))
+			return false;
 	}
 
-	return out;
+	return true;
 }
 
 void FolderData::addChild(FileData* file)
@@ -482,10 +657,15 @@ void FolderData::addChild(FileData* file)
 	assert(mType == FOLDER);
 	assert(file->getParent() == NULL);
 
-	const std::string key = file->getKey();
-
 	mChildren.push_back(file);
-	file->setParent(this);	
+	file->setParent(this);
+
+	if (file->getType() == GAME)
+		addGameCount(1);
+	else if (file->getType() == FOLDER)
+		addGameCount(((FolderData*)file)->getGameCount());
+
+	invalidateDisplayedChildren();
 }
 
 void FolderData::removeChild(FileData* file)
@@ -499,6 +679,13 @@ void FolderData::removeChild(FileData* file)
 		{
 			file->setParent(NULL);
 			mChildren.erase(it);
+
+			if (file->getType() == GAME)
+				addGameCount(-1);
+			else if (file->getType() == FOLDER)
+				addGameCount(-((FolderData*)file)->getGameCount());
+
+			invalidateDisplayedChildren();
 			return;
 		}
 	}
@@ -508,8 +695,22 @@ void FolderData::removeChild(FileData* file)
 
 }
 
+void FolderData::addGameCount(int count)
+{
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		folder->mGameCount += count;
+}
+
+void FolderData::invalidateDisplayedChildren()
+{
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		folder->mDisplayVersion++;
+}
+
 void FolderData::sort(ComparisonFunction& comparator, bool ascending)
 {
+	invalidateDisplayedChildren();
+
 	std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
 
 	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
@@ -529,7 +730,20 @@ void FolderData::sort(ComparisonFunction& comparator, bool ascending)
 
 void FolderData::sort(const SortType& type)
 {
-	sort(*type.comparisonFunction, type.ascending);
+	invalidateDisplayedChildren();
+
+	FileSorts::sortFiles(mChildren, type);
+
+	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		if ((*it)->getType() != FOLDER)
+			continue;
+
+		FolderData* folder = (FolderData*)(*it);
+
+		if (folder->getChildren().size() > 0)
+			folder->sort(type);
+	}
 }
 
 FileData* FolderData::FindByPath(const std::string& path)
@@ -4,6 +4,9 @@
 
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 
 class SystemData;
@@ -25,8 +28,43 @@ enum FileChangeType
 	FILE_SORTED
 };
 
+class FileFilterIndex;
 class FolderData;
 
+// Slots of the nodes of one system, in blocks of same size slots : the nodes of a system are next to each other,
+// systems scanned in parallel don't share a lock, and the blocks are freed with the system.
+class FileDataPool
+{
+public:
+	FileDataPool();
+
+	void* allocate(size_t size);
+	static void deallocate(void* ptr);
+
+	// Called by the system owning the pool, it's deleted once its last node is
+	void release();
+
+private:
+	~FileDataPool();
+
+	void freeSlot(void* slot, size_t slots);
+
+	struct SizeClass
+	{
+		SizeClass() : freeSlots(nullptr), block(nullptr), blockUsed(0) { }
+
+		void*	freeSlots;	// freed slots, each one holds the next
+		char*	block;		// block being carved
+		size_t	blockUsed;
+	};
+
+	std::mutex				mLock;
+	std::vector<SizeClass>	mSizes;
+	std::vector<char*>		mBlocks;
+	size_t					mLiveSlots;
+	bool					mReleased;
+};
+
 // A tree node that holds information for a file.
 class FileData
 {
@@ -34,6 +72,12 @@ public:
 	FileData(FileType type, const std::string& path, SystemData* system);
 	virtual ~FileData();
 
+	// Nodes are allocated from the pool of their system instead of one by one, they are created by tens of thousands.
+	// Use new (system) FileData(type, path, system).
+	static void* operator new(size_t size, SystemData* system);
+	static void operator delete(void* ptr, SystemData* system);
+	static void operator delete(void* ptr);
+
 	virtual const std::string getName();
 
 	inline FileType getType() const { return mType; }
@@ -63,6 +107,9 @@ public:
 
 	virtual inline void refreshMetadata() { return; };
 
+	// Called by the metadata on every change : the displayed lists of the parent folders are invalidated
+	void onMetadataChanged();
+
 	virtual std::string getKey();
 	const bool isArcadeAsset();
 	inline std::string getFullPath() { return getPath(); };
@@ -112,7 +159,7 @@ private:
 class FolderData : public FileData
 {
 public:
-	FolderData(const std::string& startpath, SystemData* system) : FileData(FOLDER, startpath, system)
+	FolderData(const std::string& startpath, SystemData* system) : FileData(FOLDER, startpath, system), mGameCount(0), mDisplayVersion(0)
 	{
 	}
 
@@ -124,15 +171,27 @@ public:
 		mChildren.clear();
 	}
 
+	// Normalized value extracted once per entry before sorting : compared by number, then by text
+	struct SortKey
+	{
+		SortKey() : number(0) {}
+
+		double number;
+		std::string text;
+	};
+
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
+	typedef void KeyFunction(const FileData* file, SortKey& key);
+
 	struct SortType
 	{
 		ComparisonFunction* comparisonFunction;
+		KeyFunction* keyFunction;
 		bool ascending;
 		std::string description;
 
-		SortType(ComparisonFunction* sortFunction, bool sortAscending, const std::string & sortDescription)
-			: comparisonFunction(sortFunction), ascending(sortAscending), description(sortDescription) {}
+		SortType(ComparisonFunction* sortFunction, KeyFunction* sortKeyFunction, bool sortAscending, const std::string & sortDescription)
+			: comparisonFunction(sortFunction), keyFunction(sortKeyFunction), ascending(sortAscending), description(sortDescription) {}
 	};
 
 	void sort(ComparisonFunction& comparator, bool ascending = true);
@@ -146,6 +205,21 @@ public:
 	const std::vector<FileData*> getChildrenListToDisplay();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false, SystemData* system = nullptr) const;
 
+	// Walks the subtree depth first without building lists, until the function returns false.
+	// Returns false if the walk was stopped.
+	bool forEachFile(unsigned int typeMask, bool displayedOnly, const std::function<bool(FileData*)>& function, SystemData* system = nullptr) const;
+
+	// Games in this folder and its subfolders, kept up to date by addChild and removeChild
+	inline int getGameCount() const { return mGameCount; }
+
+	// Changes whenever the displayed lists of this folder may change : children added or removed, sorting or metadata
+	// changes in the folder or its subfolders, and filters
+	unsigned long long getDisplayVersion() const;
+	// To be called when something else than the tree and the metadata changes what is displayed (i.e. filters)
+	static void invalidateDisplayedLists();
+	// Invalidates the displayed lists of this folder and its parents, which may list the same games
+	void invalidateDisplayedChildren();
+
 	void addChild(FileData* file); // Error if mType != FOLDER
 	void removeChild(FileData* file); //Error if mType != FOLDER
 
@@ -153,8 +227,36 @@ public:
 
 private:
 	std::vector<FileData*> getFlatGameList(bool displayedOnly, SystemData* system) const;
+	bool forEachFile(unsigned int typeMask, FileFilterIndex* idx, const std::function<bool(FileData*)>& function) const;
+	void addGameCount(int count);
 
 	std::vector<FileData*> mChildren;
+	int mGameCount;
+	unsigned int mDisplayVersion;
+
+	// Everything getChildrenListToDisplay depends on, the list is built again only when it changes
+	struct DisplayState
+	{
+		DisplayState() : version(0), index(nullptr), sortId(0), flatFolders(false), showHiddenFiles(false), filterKidGame(false) {}
+
+		bool operator==(const DisplayState& other) const
+		{
+			return version == other.version && index == other.index && sortId == other.sortId &&
+				flatFolders == other.flatFolders && showHiddenFiles == other.showHiddenFiles && filterKidGame == other.filterKidGame;
+		}
+
+		unsigned long long version;
+		FileFilterIndex* index;
+		unsigned int sortId;
+		bool flatFolders;
+		bool showHiddenFiles;
+		bool filterKidGame;
+	};
+
+	DisplayState mDisplayedState;
+	std::vector<FileData*> mDisplayedChildren;
+
+	static std::atomic<unsigned int> sDisplayVersion;
 };
 
 FolderData::SortType getSortTypeFromString(std::string desc);
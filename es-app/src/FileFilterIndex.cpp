@@ -5,12 +5,39 @@
 #include "FileData.h"
 #include "Log.h"
 #include "Settings.h"
+#include <algorithm>
 
 #define UNKNOWN_LABEL "UNKNOWN"
 #define INCLUDE_UNKNOWN false;
 
+namespace
+{
+	inline void setBit(std::vector<unsigned long long>& bitmap, int id)
+	{
+		size_t word = id / 64;
+		if (word >= bitmap.size())
+			bitmap.resize(word + 1, 0);
+
+		bitmap[word] |= 1ULL << (id % 64);
+	}
+
+	inline void clearBit(std::vector<unsigned long long>& bitmap, int id)
+	{
+		size_t word = id / 64;
+		if (word < bitmap.size())
+			bitmap[word] &= ~(1ULL << (id % 64));
+	}
+
+	inline bool testBit(const std::vector<unsigned long long>& bitmap, int id)
+	{
+		size_t word = id / 64;
+		return word < bitmap.size() && (bitmap[word] & (1ULL << (id % 64))) != 0;
+	}
+}
+
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), mMatchesDirty(true),
+	mNameIndexBuilt(false), mTextMatchesDirty(true)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -25,6 +52,7 @@ FileFilterIndex::FileFilterIndex()
 	};
 
 	filterDataDecl = std::vector<FilterDataDecl>(filterDecls, filterDecls + sizeof(filterDecls) / sizeof(filterDecls[0]));
+	resetBitmaps();
 }
 
 FileFilterIndex::~FileFilterIndex()
@@ -83,6 +111,7 @@ void FileFilterIndex::resetIndex()
 	clearIndex(favoritesIndexAllKeys);
 	// clearIndex(hiddenIndexAllKeys);
 	clearIndex(kidGameIndexAllKeys);
+	resetBitmaps();
 }
 
 std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary)
@@ -188,6 +217,8 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageFavoritesEntryInIndex(game);
 	//manageHiddenEntryInIndex(game);
 	manageKidGameEntryInIndex(game);
+
+	getGameId(game);
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -199,6 +230,20 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageFavoritesEntryInIndex(game, true);
 	//manageHiddenEntryInIndex(game, true);
 	manageKidGameEntryInIndex(game, true);
+
+	auto it = mGameIds.find(game);
+	if (it != mGameIds.cend())
+	{
+		unindexGame(it->second);
+		clearBit(mMatches, it->second);
+		clearBit(mTextMatches, it->second);
+
+		if (mNameIndexBuilt)
+			mNameIndex.remove(it->second);
+
+		mFreeIds.push_back(it->second);
+		mGameIds.erase(it);
+	}
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
@@ -210,10 +255,13 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 	}
 	else
 	{
+		mMatchesDirty = true;
+		FolderData::invalidateDisplayedLists();
+
 		for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
 			if ((*it).type == type)
 			{
-				FilterDataDecl filterData = (*it);
+				const FilterDataDecl& filterData = (*it);
 				*(filterData.filteredByRef) = values->size() > 0;
 				filterData.currentFilteredKeys->clear();
 				for (std::vector<std::string>::const_iterator vit = values->cbegin(); vit != values->cend(); ++vit ) {
@@ -230,9 +278,12 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	mMatchesDirty = true;
+	FolderData::invalidateDisplayedLists();
+
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
-		FilterDataDecl filterData = (*it);
+		const FilterDataDecl& filterData = (*it);
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
@@ -292,6 +343,20 @@ void FileFilterIndex::debugPrintIndexes()
 void FileFilterIndex::setTextFilter(const std::string text)
 {
 	mTextFilter = Utils::String::toUpper(text);
+	mFoldedTextFilter = Utils::String::foldForSearch(text);
+	mTextMatchesDirty = true;
+
+	FolderData::invalidateDisplayedLists();
+}
+
+int FileFilterIndex::countTextMatches(const std::string& text)
+{
+	std::string folded = Utils::String::foldForSearch(text);
+	if (folded.empty())
+		return 0;
+
+	buildNameIndex();
+	return (int)mNameIndex.find(folded).size();
 }
 
 bool FileFilterIndex::showFile(FileData* game)
@@ -304,7 +369,7 @@ bool FileFilterIndex::showFile(FileData* game)
 	// that should be shown
 	if (game->getType() == FOLDER) 
 	{
-		std::vector<FileData*> children = ((FolderData*) game)->getChildren();
+		const std::vector<FileData*>& children = ((FolderData*) game)->getChildren();
 		// iterate through all of the children, until there's a match
 
 		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
@@ -314,64 +379,254 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
-	bool keepGoing = false;
+	bool filteredByKeys = false;
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+		filteredByKeys |= *((*it).filteredByRef);
 
-	if (!mTextFilter.empty() && Utils::String::toUpper(game->getName()).find(mTextFilter) != std::string::npos)
-		keepGoing = true;
+	// the text filter only counts when no other filter is set
+	if (!filteredByKeys)
+	{
+		if (mFoldedTextFilter.empty())
+			return false;
 
-	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
-		FilterDataDecl filterData = (*it);
-		if(*(filterData.filteredByRef))
-		{
-			// try to find a match
-			std::string key = getIndexableKey(game, filterData.type, false);
-			keepGoing = isKeyBeingFilteredBy(key, filterData.type);
+		// the game is (re)indexed first, its name may have changed
+		int id = getGameId(game);
+		updateTextMatches();
+		return testBit(mTextMatches, id);
+	}
 
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!keepGoing)
-			{
-				if (!filterData.hasSecondaryKey)
-				{
-					return false;
-				}
-				std::string secKey = getIndexableKey(game, filterData.type, true);
-				if (secKey != UNKNOWN_LABEL)
-				{
-					keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
-				}
-			}
-			// if still nothing, then it's not a match
-			if (!keepGoing)
-				return false;
+	// a game must match every filter set, with its primary key or secondary keys (i.e. publisher and dev, or first genre)
+	// reindexing may add a key and leave the matches dirty, so it goes before the update
+	int id = getGameId(game);
+	updateMatches();
+	return testBit(mMatches, id);
+}
+
+bool FileFilterIndex::isKeyBeingFilteredBy(const std::string& key, FilterIndexType type)
+{
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		if ((*it).type == type)
+			return std::find((*it).currentFilteredKeys->cbegin(), (*it).currentFilteredKeys->cend(), key) != (*it).currentFilteredKeys->cend();
+	}
+
+	return false;
+}
+
+int FileFilterIndex::getGameId(FileData* game)
+{
+	unsigned int version = game->metadata.getVersion();
 
+	auto it = mGameIds.find(game);
+	if (it != mGameIds.cend())
+	{
+		// the keys are read again only if the metadata changed since
+		if (mGameVersions[it->second] != version)
+		{
+			unindexGame(it->second);
+			indexGame(it->second, game);
 		}
 
+		return it->second;
+	}
+
+	int id;
+	if (!mFreeIds.empty())
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
 	}
+	else
+	{
+		id = (int)mGameVersions.size();
+		mGameVersions.push_back(0);
+		mGameKeys.resize(mGameKeys.size() + filterDataDecl.size() * 2, -1);
+	}
+
+	mGameIds[game] = id;
+	indexGame(id, game);
 
-	return keepGoing;
+	return id;
 }
 
-bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
+void FileFilterIndex::indexGame(int id, FileData* game)
 {
-	const FilterIndexType filterTypes[6] = { FAVORITES_FILTER, GENRE_FILTER, PLAYER_FILTER, PUBDEV_FILTER, RATINGS_FILTER, KIDGAME_FILTER }; // ,HIDDEN_FILTER
-	std::vector<std::string> filterKeysList[6] = { favoritesIndexFilteredKeys, genreIndexFilteredKeys, playersIndexFilteredKeys, pubDevIndexFilteredKeys, ratingsIndexFilteredKeys, kidGameIndexFilteredKeys }; // hiddenIndexFilteredKeys, 
+	mGameVersions[id] = game->metadata.getVersion();
 
-	for (int i = 0; i < 6; i++)
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
 	{
-		if (filterTypes[i] == type)
+		const FilterDataDecl& filterData = filterDataDecl[i];
+		int* keys = &mGameKeys[(id * filterDataDecl.size() + i) * 2];
+
+		for (int secondary = 0; secondary < 2; secondary++)
 		{
-			for (std::vector<std::string>::const_iterator it = filterKeysList[i].cbegin(); it != filterKeysList[i].cend(); ++it )
+			keys[secondary] = -1;
+
+			if (secondary && !filterData.hasSecondaryKey)
+				continue;
+
+			std::string key = getIndexableKey(game, filterData.type, secondary != 0);
+			if (secondary && key == UNKNOWN_LABEL)
+				continue;
+
+			auto keyId = mKeyIds[i].find(key);
+			if (keyId == mKeyIds[i].cend())
 			{
-				if (key == (*it))
-				{
-					return true;
-				}
+				keyId = mKeyIds[i].insert(std::make_pair(key, (int)mKeyGames[i].size())).first;
+				mKeyGames[i].push_back(Bitmap());
+				mMatchesDirty = true; // it may be one of the filtered keys
 			}
+
+			keys[secondary] = keyId->second;
+			setBit(mKeyGames[i][keyId->second], id);
+		}
+	}
+
+	if (mNameIndexBuilt)
+	{
+		mNameIndex.set(id, Utils::String::foldForSearch(game->getName()));
+
+		if (!mTextMatchesDirty)
+		{
+			if (!mFoldedTextFilter.empty() && mNameIndex.contains(id, mFoldedTextFilter))
+				setBit(mTextMatches, id);
+			else
+				clearBit(mTextMatches, id);
+		}
+	}
+
+	if (mMatchesDirty)
+		return;
+
+	if (matchesFilters(id))
+		setBit(mMatches, id);
+	else
+		clearBit(mMatches, id);
+}
+
+void FileFilterIndex::unindexGame(int id)
+{
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
+	{
+		int* keys = &mGameKeys[(id * filterDataDecl.size() + i) * 2];
+
+		for (int secondary = 0; secondary < 2; secondary++)
+		{
+			if (keys[secondary] >= 0)
+				clearBit(mKeyGames[i][keys[secondary]], id);
+
+			keys[secondary] = -1;
+		}
+	}
+}
+
+bool FileFilterIndex::matchesFilters(int id)
+{
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
+	{
+		if (!*(filterDataDecl[i].filteredByRef))
+			continue;
+
+		const int* keys = &mGameKeys[(id * filterDataDecl.size() + i) * 2];
+		const std::vector<int>& filteredKeys = mFilteredKeyIds[i];
+
+		bool match = false;
+		for (int secondary = 0; secondary < 2 && !match; secondary++)
+			match = keys[secondary] >= 0 && std::find(filteredKeys.cbegin(), filteredKeys.cend(), keys[secondary]) != filteredKeys.cend();
+
+		if (!match)
 			return false;
+	}
+
+	return true;
+}
+
+void FileFilterIndex::updateMatches()
+{
+	if (!mMatchesDirty)
+		return;
+
+	mMatchesDirty = false;
+
+	size_t words = (mGameVersions.size() + 63) / 64;
+	mMatches.assign(words, ~0ULL);
+
+	Bitmap declMatches;
+
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
+	{
+		const FilterDataDecl& filterData = filterDataDecl[i];
+
+		mFilteredKeyIds[i].clear();
+		if (!*(filterData.filteredByRef))
+			continue;
+
+		// games having any of the keys
+		declMatches.assign(words, 0);
+
+		for (auto key = filterData.currentFilteredKeys->cbegin(); key != filterData.currentFilteredKeys->cend(); ++key)
+		{
+			auto keyId = mKeyIds[i].find(*key);
+			if (keyId == mKeyIds[i].cend())
+				continue;
+
+			mFilteredKeyIds[i].push_back(keyId->second);
+
+			const Bitmap& games = mKeyGames[i][keyId->second];
+			for (size_t w = 0; w < games.size() && w < words; w++)
+				declMatches[w] |= games[w];
 		}
+
+		// and every filter set
+		for (size_t w = 0; w < words; w++)
+			mMatches[w] &= declMatches[w];
 	}
+}
 
-	return false;
+void FileFilterIndex::resetBitmaps()
+{
+	mGameIds.clear();
+	mGameVersions.clear();
+	mGameKeys.clear();
+	mFreeIds.clear();
+
+	mKeyIds.assign(filterDataDecl.size(), std::unordered_map<std::string, int>());
+	mKeyGames.assign(filterDataDecl.size(), std::vector<Bitmap>());
+	mFilteredKeyIds.assign(filterDataDecl.size(), std::vector<int>());
+
+	mMatches.clear();
+	mMatchesDirty = true;
+
+	mNameIndex.clear();
+	mNameIndexBuilt = false;
+	mTextMatches.clear();
+	mTextMatchesDirty = true;
+}
+
+void FileFilterIndex::buildNameIndex()
+{
+	if (mNameIndexBuilt)
+		return;
+
+	// The names are folded once, then kept up to date by indexGame
+	for (auto it = mGameIds.cbegin(); it != mGameIds.cend(); ++it)
+		mNameIndex.set(it->second, Utils::String::foldForSearch(it->first->getName()));
+
+	mNameIndexBuilt = true;
+}
+
+void FileFilterIndex::updateTextMatches()
+{
+	if (!mTextMatchesDirty)
+		return;
+
+	buildNameIndex();
+
+	mTextMatchesDirty = false;
+	mTextMatches.assign((mGameVersions.size() + 63) / 64, 0);
+
+	for (auto id : mNameIndex.find(mFoldedTextFilter))
+		setBit(mTextMatches, id);
 }
 
 void FileFilterIndex::manageGenreEntryInIndex(FileData* game, bool remove)
@@ -2,7 +2,10 @@
 #ifndef ES_APP_FILE_FILTER_INDEX_H
 #define ES_APP_FILE_FILTER_INDEX_H
 
+#include "GameNameIndex.h"
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class FileData;
@@ -43,7 +46,7 @@ public:
 	void debugPrintIndexes();
 	bool showFile(FileData* game);
 	bool isFiltered() { return (!mTextFilter.empty() || filterByGenre || filterByPlayers || filterByPubDev || filterByRatings || filterByFavorites || filterByHidden || filterByKidGame); };
-	bool isKeyBeingFilteredBy(std::string key, FilterIndexType type);
+	bool isKeyBeingFilteredBy(const std::string& key, FilterIndexType type);
 	std::vector<FilterDataDecl>& getFilterDataDecls();
 
 	void importIndex(FileFilterIndex* indexToImport);
@@ -54,6 +57,9 @@ public:
 	void setTextFilter(const std::string text);
 	inline const std::string getTextFilter() { return mTextFilter; }
 
+	// Number of games whose name contains the text, for the live count while typing
+	int countTextMatches(const std::string& text);
+
 private:
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
@@ -70,6 +76,39 @@ private:
 
 	void clearIndex(std::map<std::string, int> indexMap);
 
+	// Bitmap engine : every game gets an id, every distinct key of a filter declaration a bitmap of the games
+	// having it (primary or secondary). A filter set is evaluated once as ORs of the selected keys and ANDs
+	// between declarations, showFile only tests the bit of the game.
+	typedef std::vector<unsigned long long> Bitmap;
+
+	int getGameId(FileData* game);
+	void indexGame(int id, FileData* game);
+	void unindexGame(int id);
+	bool matchesFilters(int id);
+	void updateMatches();
+	void resetBitmaps();
+	void buildNameIndex();
+	void updateTextMatches();
+
+	std::unordered_map<FileData*, int>	mGameIds;
+	std::vector<unsigned int>			mGameVersions;	// metadata version the keys of each game were read from
+	std::vector<int>					mGameKeys;		// per game and declaration : primary and secondary key ids, -1 if none
+	std::vector<int>					mFreeIds;
+
+	std::vector<std::unordered_map<std::string, int>>	mKeyIds;	// per declaration
+	std::vector<std::vector<Bitmap>>					mKeyGames;	// per declaration and key id
+	std::vector<std::vector<int>>						mFilteredKeyIds; // per declaration, ids of currentFilteredKeys
+
+	Bitmap	mMatches;
+	bool	mMatchesDirty;
+
+	// Folded names, indexed on the first text search
+	GameNameIndex	mNameIndex;
+	bool			mNameIndexBuilt;
+	std::string		mFoldedTextFilter;
+	Bitmap			mTextMatches;
+	bool			mTextMatchesDirty;
+
 	bool filterByGenre;
 	bool filterByPlayers;
 	bool filterByPubDev;
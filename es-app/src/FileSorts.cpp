@@ -1,39 +1,41 @@
 #include "FileSorts.h"
 
 #include "utils/StringUtil.h"
+#include "utils/TaskScheduler.h"
+#include <algorithm>
 
 namespace FileSorts
 {
 	const FolderData::SortType typesArr[] = {
-		FolderData::SortType(&compareName, true, "filename, ascending"),
-		FolderData::SortType(&compareName, false, "filename, descending"),
+		FolderData::SortType(&compareName, &nameKey, true, "filename, ascending"),
+		FolderData::SortType(&compareName, &nameKey, false, "filename, descending"),
 
-		FolderData::SortType(&compareRating, true, "rating, ascending"),
-		FolderData::SortType(&compareRating, false, "rating, descending"),
+		FolderData::SortType(&compareRating, &ratingKey, true, "rating, ascending"),
+		FolderData::SortType(&compareRating, &ratingKey, false, "rating, descending"),
 
-		FolderData::SortType(&compareTimesPlayed, true, "times played, ascending"),
-		FolderData::SortType(&compareTimesPlayed, false, "times played, descending"),
+		FolderData::SortType(&compareTimesPlayed, &timesPlayedKey, true, "times played, ascending"),
+		FolderData::SortType(&compareTimesPlayed, &timesPlayedKey, false, "times played, descending"),
 
-		FolderData::SortType(&compareLastPlayed, true, "last played, ascending"),
-		FolderData::SortType(&compareLastPlayed, false, "last played, descending"),
+		FolderData::SortType(&compareLastPlayed, &lastPlayedKey, true, "last played, ascending"),
+		FolderData::SortType(&compareLastPlayed, &lastPlayedKey, false, "last played, descending"),
 
-		FolderData::SortType(&compareNumPlayers, true, "number of players, ascending"),
-		FolderData::SortType(&compareNumPlayers, false, "number of players, descending"),
+		FolderData::SortType(&compareNumPlayers, &numPlayersKey, true, "number of players, ascending"),
+		FolderData::SortType(&compareNumPlayers, &numPlayersKey, false, "number of players, descending"),
 
-		FolderData::SortType(&compareReleaseDate, true, "release date, ascending"),
-		FolderData::SortType(&compareReleaseDate, false, "release date, descending"),
+		FolderData::SortType(&compareReleaseDate, &releaseDateKey, true, "release date, ascending"),
+		FolderData::SortType(&compareReleaseDate, &releaseDateKey, false, "release date, descending"),
 
-		FolderData::SortType(&compareGenre, true, "genre, ascending"),
-		FolderData::SortType(&compareGenre, false, "genre, descending"),
+		FolderData::SortType(&compareGenre, &genreKey, true, "genre, ascending"),
+		FolderData::SortType(&compareGenre, &genreKey, false, "genre, descending"),
 
-		FolderData::SortType(&compareDeveloper, true, "developer, ascending"),
-		FolderData::SortType(&compareDeveloper, false, "developer, descending"),
+		FolderData::SortType(&compareDeveloper, &developerKey, true, "developer, ascending"),
+		FolderData::SortType(&compareDeveloper, &developerKey, false, "developer, descending"),
 
-		FolderData::SortType(&comparePublisher, true, "publisher, ascending"),
-		FolderData::SortType(&comparePublisher, false, "publisher, descending"),
+		FolderData::SortType(&comparePublisher, &publisherKey, true, "publisher, ascending"),
+		FolderData::SortType(&comparePublisher, &publisherKey, false, "publisher, descending"),
 
-		FolderData::SortType(&compareSystem, true, "system, ascending"),
-		FolderData::SortType(&compareSystem, false, "system, descending")
+		FolderData::SortType(&compareSystem, &systemKey, true, "system, ascending"),
+		FolderData::SortType(&compareSystem, &systemKey, false, "system, descending")
 	};
 
 	const std::vector<FolderData::SortType> SortTypes(typesArr, typesArr + sizeof(typesArr)/sizeof(typesArr[0]));
@@ -48,7 +50,7 @@ namespace FileSorts
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->metadata.getFloat("rating") < file2->metadata.getFloat("rating");
+		return file1->metadata.getFloat(MetaDataId::Rating) < file2->metadata.getFloat(MetaDataId::Rating);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -56,7 +58,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if(file1->metadata.getType() == GAME_METADATA && file2->metadata.getType() == GAME_METADATA)
 		{
-			return (file1)->metadata.getInt("playcount") < (file2)->metadata.getInt("playcount");
+			return (file1)->metadata.getInt(MetaDataId::PlayCount) < (file2)->metadata.getInt(MetaDataId::PlayCount);
 		}
 
 		return false;
@@ -64,41 +66,37 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("lastplayed") < (file2)->metadata.get("lastplayed");
+		return (file1)->metadata.getDate(MetaDataId::LastPlayed) < (file2)->metadata.getDate(MetaDataId::LastPlayed);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->metadata.getInt("players") < (file2)->metadata.getInt("players");
+		return (file1)->metadata.getInt(MetaDataId::Players) < (file2)->metadata.getInt(MetaDataId::Players);
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("releasedate") < (file2)->metadata.get("releasedate");
+		return (file1)->metadata.getDate(MetaDataId::ReleaseDate) < (file2)->metadata.getDate(MetaDataId::ReleaseDate);
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->metadata.get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->metadata.get("genre"));
+		std::string genre1 = Utils::String::toUpper(file1->metadata.get(MetaDataId::Genre));
+		std::string genre2 = Utils::String::toUpper(file2->metadata.get(MetaDataId::Genre));
 		return genre1.compare(genre2) < 0;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->metadata.get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->metadata.get("developer"));
+		std::string developer1 = Utils::String::toUpper(file1->metadata.get(MetaDataId::Developer));
+		std::string developer2 = Utils::String::toUpper(file2->metadata.get(MetaDataId::Developer));
 		return developer1.compare(developer2) < 0;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->metadata.get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->metadata.get("publisher"));
+		std::string publisher1 = Utils::String::toUpper(file1->metadata.get(MetaDataId::Publisher));
+		std::string publisher2 = Utils::String::toUpper(file2->metadata.get(MetaDataId::Publisher));
 		return publisher1.compare(publisher2) < 0;
 	}
 
@@ -108,4 +106,131 @@ namespace FileSorts
 		std::string system2 = Utils::String::toUpper(file2->getSystemName());
 		return system1.compare(system2) < 0;
 	}
+
+	// Sort keys, must give the same order as the comparison functions above
+
+	void nameKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->metadata.getName());
+	}
+
+	void ratingKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.number = file->metadata.getFloat(MetaDataId::Rating);
+	}
+
+	void timesPlayedKey(const FileData* file, FolderData::SortKey& key)
+	{
+		//only games have playcount metadata
+		if (file->metadata.getType() == GAME_METADATA)
+			key.number = file->metadata.getInt(MetaDataId::PlayCount);
+	}
+
+	void lastPlayedKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.number = (double)file->metadata.getDate(MetaDataId::LastPlayed);
+	}
+
+	void numPlayersKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.number = file->metadata.getInt(MetaDataId::Players);
+	}
+
+	void releaseDateKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.number = (double)file->metadata.getDate(MetaDataId::ReleaseDate);
+	}
+
+	void genreKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->metadata.get(MetaDataId::Genre));
+	}
+
+	void developerKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->metadata.get(MetaDataId::Developer));
+	}
+
+	void publisherKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->metadata.get(MetaDataId::Publisher));
+	}
+
+	void systemKey(const FileData* file, FolderData::SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getSystemName());
+	}
+
+	struct KeyedFile
+	{
+		FolderData::SortKey key;
+		FileData* file;
+	};
+
+	static bool compareKeys(const KeyedFile& a, const KeyedFile& b)
+	{
+		if (a.key.number != b.key.number)
+			return a.key.number < b.key.number;
+
+		return a.key.text < b.key.text;
+	}
+
+	// Below this, splitting the work costs more than it saves
+	static const size_t PARALLEL_SORT_THRESHOLD = 4096;
+
+	void sortFiles(std::vector<FileData*>& files, const FolderData::SortType& type)
+	{
+		size_t count = files.size();
+		if (count < 2)
+			return;
+
+		size_t chunks = 1;
+		if (count >= PARALLEL_SORT_THRESHOLD)
+			chunks = std::max((size_t)1, std::min(Utils::TaskScheduler::getInstance()->getWorkerCount() + 1, count / (PARALLEL_SORT_THRESHOLD / 2)));
+
+		std::vector<KeyedFile> entries(count);
+		std::vector<size_t> bounds;
+		for (size_t i = 0; i <= chunks; i++)
+			bounds.push_back(count * i / chunks);
+
+		// Extract keys and sort each chunk on a worker, the calling thread takes the first one
+		auto sortChunk = [&files, &entries, &bounds, &type](size_t chunk)
+		{
+			for (size_t i = bounds[chunk]; i < bounds[chunk + 1]; i++)
+			{
+				entries[i].file = files[i];
+				type.keyFunction(files[i], entries[i].key);
+			}
+
+			std::stable_sort(entries.begin() + bounds[chunk], entries.begin() + bounds[chunk + 1], compareKeys);
+		};
+
+		Utils::TaskGroup tasks;
+		for (size_t chunk = 1; chunk < chunks; chunk++)
+			tasks.run([&sortChunk, chunk] { sortChunk(chunk); });
+
+		sortChunk(0);
+		tasks.wait();
+
+		// Merge sorted neighbours two by two, merges of a same pass are independent
+		for (size_t width = 1; width < chunks; width *= 2)
+		{
+			for (size_t chunk = 0; chunk + width < chunks; chunk += width * 2)
+			{
+				auto first = entries.begin() + bounds[chunk];
+				auto middle = entries.begin() + bounds[chunk + width];
+				auto last = entries.begin() + bounds[std::min(chunk + width * 2, chunks)];
+
+				tasks.run([first, middle, last] { std::inplace_merge(first, middle, last, compareKeys); });
+			}
+
+			tasks.wait();
+		}
+
+		for (size_t i = 0; i < count; i++)
+			files[i] = entries[i].file;
+
+		if (!type.ascending)
+			std::reverse(files.begin(), files.end());
+	}
 };
@@ -18,6 +18,20 @@ namespace FileSorts
 	bool comparePublisher(const FileData* file1, const FileData* file2);
 	bool compareSystem(const FileData* file1, const FileData* file2);
 
+	void nameKey(const FileData* file, FolderData::SortKey& key);
+	void ratingKey(const FileData* file, FolderData::SortKey& key);
+	void timesPlayedKey(const FileData* file, FolderData::SortKey& key);
+	void lastPlayedKey(const FileData* file, FolderData::SortKey& key);
+	void numPlayersKey(const FileData* file, FolderData::SortKey& key);
+	void releaseDateKey(const FileData* file, FolderData::SortKey& key);
+	void genreKey(const FileData* file, FolderData::SortKey& key);
+	void developerKey(const FileData* file, FolderData::SortKey& key);
+	void publisherKey(const FileData* file, FolderData::SortKey& key);
+	void systemKey(const FileData* file, FolderData::SortKey& key);
+
+	// Extracts the sort key of every file once, then sorts them (on several threads for big lists)
+	void sortFiles(std::vector<FileData*>& files, const FolderData::SortType& type);
+
 	extern const std::vector<FolderData::SortType> SortTypes;
 };
 
@@ -0,0 +1,160 @@
+#include "GameNameIndex.h"
+
+#include "Profiler.h"
+#include <algorithm>
+
+// Below that, queries scan the names
+#define TRIGRAM_LENGTH			3
+// Fraction of the names that can be changed before the trigrams are indexed again
+#define LOOSE_NAMES_DIVISOR		8
+
+GameNameIndex::GameNameIndex() : mBuilt(false), mLastValid(false)
+{
+}
+
+unsigned int GameNameIndex::getTrigram(const std::string& text, size_t pos)
+{
+	return ((unsigned char)text[pos] << 16) | ((unsigned char)text[pos + 1] << 8) | (unsigned char)text[pos + 2];
+}
+
+void GameNameIndex::set(int id, const std::string& folded)
+{
+	if (id >= (int)mNames.size())
+		mNames.resize(id + 1);
+	else if (mNames[id] == folded)
+		return;
+
+	mNames[id] = folded;
+	mLastValid = false;
+
+	if (!mBuilt)
+		return;
+
+	// The old trigrams of the name stay indexed, every candidate is verified anyway
+	mLooseIds.push_back(id);
+
+	if (mLooseIds.size() > mNames.size() / LOOSE_NAMES_DIVISOR + 64)
+	{
+		mBuilt = false;
+		mTrigrams.clear();
+		mLooseIds.clear();
+	}
+}
+
+void GameNameIndex::remove(int id)
+{
+	if (id < (int)mNames.size() && !mNames[id].empty())
+	{
+		mNames[id].clear();
+		mLastValid = false;
+	}
+}
+
+void GameNameIndex::clear()
+{
+	mNames.clear();
+	mTrigrams.clear();
+	mLooseIds.clear();
+	mBuilt = false;
+
+	mLastQuery.clear();
+	mLastResults.clear();
+	mLastValid = false;
+}
+
+bool GameNameIndex::contains(int id, const std::string& folded) const
+{
+	return id < (int)mNames.size() && !mNames[id].empty() && mNames[id].find(folded) != std::string::npos;
+}
+
+void GameNameIndex::build()
+{
+	PROFILE_SCOPE("GameNameIndex::build");
+
+	mTrigrams.clear();
+	mLooseIds.clear();
+
+	for (int id = 0; id < (int)mNames.size(); id++)
+	{
+		const std::string& name = mNames[id];
+
+		for (size_t i = 0; i + TRIGRAM_LENGTH <= name.length(); i++)
+		{
+			// ids are added in ascending order, a name repeating a trigram only needs the last one checked
+			std::vector<int>& ids = mTrigrams[getTrigram(name, i)];
+			if (ids.empty() || ids.back() != id)
+				ids.push_back(id);
+		}
+	}
+
+	mBuilt = true;
+}
+
+void GameNameIndex::findCandidates(const std::string& folded, std::vector<int>& candidates)
+{
+	candidates.clear();
+
+	if (folded.length() < TRIGRAM_LENGTH)
+	{
+		for (int id = 0; id < (int)mNames.size(); id++)
+			candidates.push_back(id);
+
+		return;
+	}
+
+	if (!mBuilt)
+		build();
+
+	// Every name containing the query has all of its trigrams, the rarest one gives the fewest names to verify
+	const std::vector<int>* rarest = nullptr;
+
+	for (size_t i = 0; i + TRIGRAM_LENGTH <= folded.length(); i++)
+	{
+		auto it = mTrigrams.find(getTrigram(folded, i));
+		if (it == mTrigrams.cend())
+		{
+			rarest = nullptr;
+			break;
+		}
+
+		if (rarest == nullptr || it->second.size() < rarest->size())
+			rarest = &it->second;
+	}
+
+	if (rarest != nullptr)
+		candidates = *rarest;
+
+	if (!mLooseIds.empty())
+	{
+		candidates.insert(candidates.end(), mLooseIds.cbegin(), mLooseIds.cend());
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	}
+}
+
+const std::vector<int>& GameNameIndex::find(const std::string& folded)
+{
+	if (mLastValid && folded == mLastQuery)
+		return mLastResults;
+
+	PROFILE_SCOPE("GameNameIndex::find");
+
+	std::vector<int> candidates;
+
+	// Typing one more letter, the results can only be a subset of the previous ones
+	if (mLastValid && !mLastQuery.empty() && folded.find(mLastQuery) != std::string::npos)
+		candidates.swap(mLastResults);
+	else
+		findCandidates(folded, candidates);
+
+	mLastResults.clear();
+
+	for (auto id : candidates)
+		if (contains(id, folded))
+			mLastResults.push_back(id);
+
+	mLastQuery = folded;
+	mLastValid = true;
+
+	return mLastResults;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef ES_APP_GAME_NAME_INDEX_H
+#define ES_APP_GAME_NAME_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Substring search over the names of a game list, by game id.
+//
+// Names are stored folded (Utils::String::foldForSearch), so queries match without case or accents. The
+// trigrams of every name are indexed the first time a query needs them : a query only verifies the games of
+// its rarest trigram. Names changed after that are checked on every query until there are too many of them
+// and the trigrams are indexed again. A query containing the previous one (the user typed one more letter)
+// only narrows the previous results.
+class GameNameIndex
+{
+public:
+	GameNameIndex();
+
+	void set(int id, const std::string& folded);
+	void remove(int id);
+	void clear();
+
+	// Ids of the games whose name contains the folded text, in ascending order
+	const std::vector<int>& find(const std::string& folded);
+	bool contains(int id, const std::string& folded) const;
+
+private:
+	void build();
+	void findCandidates(const std::string& folded, std::vector<int>& candidates);
+
+	static unsigned int getTrigram(const std::string& text, size_t pos);
+
+	std::vector<std::string>							mNames;		// by id, empty if none
+	std::unordered_map<unsigned int, std::vector<int>>	mTrigrams;	// ids of the names having each trigram, ascending
+	std::vector<int>									mLooseIds;	// names set since the trigrams were indexed
+	bool												mBuilt;
+
+	std::string			mLastQuery;
+	std::vector<int>	mLastResults;
+	bool				mLastValid;
+};
+
+#endif // ES_APP_GAME_NAME_INDEX_H
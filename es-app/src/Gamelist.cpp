@@ -5,9 +5,13 @@
 #include "FileData.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
+#include "PersistenceManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include <pugixml/src/pugixml.hpp>
+#include <chrono>
+#include <unordered_set>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -62,7 +66,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 				}
 
 				// Add final game
-				item = new FileData(GAME, path, system);
+				item = new (system) FileData(GAME, path, system);
 				if (!item->isArcadeAsset())
 				{
 					fileMap[key] = item;
@@ -83,7 +87,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 				return NULL;
 			}
 			
-			FolderData* folder = new FolderData(Utils::FileSystem::getStem(treeNode->getPath()) + "/" + *path_it, system);				
+			FolderData* folder = new (system) FolderData(Utils::FileSystem::getStem(treeNode->getPath()) + "/" + *path_it, system);				
 			treeNode->addChild(folder);
 			treeNode = folder;
 		}
@@ -112,7 +116,7 @@ void refactorGameFolders(SystemData* system)
 			{
 				childs.erase(childs.begin() + i);
 
-				FileData* newFile = new FileData(GAME, uniqueGame->getPath(), system);
+				FileData* newFile = new (system) FileData(GAME, uniqueGame->getPath(), system);
 				newFile->metadata = uniqueGame->metadata;
 				root->addChild(newFile);	
 				
@@ -122,74 +126,132 @@ void refactorGameFolders(SystemData* system)
 	}
 }
 
-void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+static void loadGamelistEntry(SystemData* system, const GamelistEntry& entry, const std::string& relativeTo, bool trustGamelist, std::unordered_map<std::string, FileData*>& fileMap)
 {
-	std::string xmlpath = system->getGamelistPath(false);
-	if (!Utils::FileSystem::exists(xmlpath))
+	const std::string path = Utils::FileSystem::resolveRelativePath(entry.path, relativeTo, false);
+
+	// files found while scanning the rom folders obviously exist, don't stat them again
+	if (!trustGamelist && fileMap.find(path) == fileMap.end() && !Utils::FileSystem::exists(path))
+	{
+		LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
 		return;
+	}
 
-	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+	FileData* file = findOrCreateFile(system, path, entry.type, fileMap);
+	if(!file)
+	{
+		LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
+		return;
+	}
+	else if(!file->isArcadeAsset())
+	{
+		std::string defaultName = file->metadata.get(MetaDataId::Name);
+		file->metadata = MetaDataList::createFromValues(GAME_METADATA, entry.values, system);
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+		//make sure name gets set if one didn't exist
+		if (file->metadata.get(MetaDataId::Name).empty())
+			file->metadata.set(MetaDataId::Name, defaultName);
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(xmlpath.c_str());
+		if (Utils::FileSystem::isHidden(path))
+			file->metadata.set(MetaDataId::Hidden, "true");
+
+		file->metadata.resetChangedFlag();
+	}
+}
+
+GamelistFile::GamelistFile()
+{
+}
+
+bool GamelistFile::load(SystemData* system)
+{
+	PROFILE_SCOPE("Gamelist::load");
+
+	mPath = system->getGamelistPath(false);
+	if (!Utils::FileSystem::exists(mPath))
+		return false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	bool useSnapshot = Settings::getInstance()->getBool("GamelistSnapshot");
+	if (useSnapshot && mSnapshot.open(mPath))
+	{
+		mEntries.resize(mSnapshot.size());
+		for (size_t i = 0; i < mSnapshot.size(); i++)
+			mSnapshot.getEntry(i, mEntries[i]);
+
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		LOG(LogInfo) << "Loaded " << mEntries.size() << " entries from the snapshot of \"" << mPath << "\" in " << (elapsed / 1000.0) << " ms";
+		return true;
+	}
+
+	LOG(LogInfo) << "Parsing XML file \"" << mPath << "\"...";
+
+	long long sourceTime = Utils::FileSystem::getModificationTime(mPath);
+
+	pugi::xml_parse_result result = mDoc.load_file(mPath.c_str());
 
 	if(!result)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		LOG(LogError) << "Error parsing XML file \"" << mPath << "\"!\n	" << result.description();
+		return false;
 	}
 
-	pugi::xml_node root = doc.child("gameList");
+	pugi::xml_node root = mDoc.child("gameList");
 	if(!root)
 	{
-		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
-		return;
+		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << mPath << "\"!";
+		return false;
 	}
 	
-	std::string relativeTo = system->getStartPath();
+	const std::vector<MetaDataDecl>& mdd = getMDDByType(GAME_METADATA);
 
 	for (pugi::xml_node fileNode : root.children())
 	{
-		FileType type = GAME;
+		GamelistEntry entry;
+		entry.type = GAME;
 
 		std::string tag = fileNode.name();
 
 		if (tag == "folder")
-			type = FOLDER;
+			entry.type = FOLDER;
 		else if (tag != "game")
 			continue;
-			
-		const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), relativeTo, false);
-		
-		if (!trustGamelist && !Utils::FileSystem::exists(path))
-		{
-			LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
-			continue;
-		}
-				
-		FileData* file = findOrCreateFile(system, path, type, fileMap);
-		if(!file)
-		{
-			LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
-			continue;
-		}
-		else if(!file->isArcadeAsset())
-		{
-			std::string defaultName = file->metadata.get("name");
-			file->metadata = MetaDataList::createFromXML(GAME_METADATA, fileNode, system);
 
-			//make sure name gets set if one didn't exist
-			if (file->metadata.get("name").empty())
-				file->metadata.set("name", defaultName);
+		entry.path = fileNode.child("path").text().get();
 
-			if (Utils::FileSystem::isHidden(path))
-				file->metadata.set("hidden", "true");
+		for (int i = 0; i < MetaDataId::Count; i++)
+			entry.values[i] = nullptr;
 
-			file->metadata.resetChangedFlag();
+		for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
+		{
+			pugi::xml_node md = fileNode.child(iter->key.c_str());
+			if (md)
+				entry.values[iter->id] = md.text().get();
 		}
+
+		mEntries.push_back(entry);
 	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	LOG(LogInfo) << "Parsed " << mEntries.size() << " entries from \"" << mPath << "\" in " << (elapsed / 1000.0) << " ms";
+
+	// next start will load the snapshot instead, unless the xml was modified meanwhile
+	if (useSnapshot && Utils::FileSystem::getModificationTime(mPath) == sourceTime)
+		GamelistSnapshot::write(mPath, GamelistSnapshot::build(root));
+
+	return true;
+}
+
+void GamelistFile::apply(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	PROFILE_SCOPE("Gamelist::apply");
+
+	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+	std::string relativeTo = system->getStartPath();
+
+	for (auto it = mEntries.cbegin(); it != mEntries.cend(); ++it)
+		loadGamelistEntry(system, *it, relativeTo, trustGamelist, fileMap);
 }
 
 bool addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* tag, SystemData* system)
@@ -216,21 +278,63 @@ bool addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* t
 	return true;
 }
 
-void updateGamelist(SystemData* system)
+// What updateGamelist captured on the main thread, merged into gamelist.xml by a worker
+struct GamelistChanges
 {
-	//We do this by reading the XML again, adding changes and then writing it back,
-	//because there might be information missing in our systemdata which would then miss in the new XML.
-	//We have the complete information for every game though, so we can simply remove a game
-	//we already have in the system from the XML, and then add it back from its GameData information...
+	struct Entry
+	{
+		int				index;			// 0 : <game>, 1 : <folder>
+		std::string		writtenPath;	// relative path, as addFileDataNode writes it
+		std::string		fullPath;
+		pugi::xml_node	node;			// new node in doc, empty when only the default name is left
+	};
+
+	std::string			systemName;
+	std::string			startPath;
+	std::string			readPath;
+	std::string			writePath;
+	bool				writeSnapshot;
+
+	pugi::xml_document	doc;
+	std::vector<Entry>	entries;
+};
+
+// True if the path is written the way addFileDataNode writes it for a file of the system folder : "./a/b" or
+// "<startPath>/a/b", without "." / ".." / empty components. Other paths ("a/../b", "~/", through a symlink to the
+// folder...) may differ from ours and still name the same file.
+static bool isNormalizedPath(const std::string& path, const std::string& startPath)
+{
+	size_t start;
+	if (path.compare(0, 2, "./") == 0)
+		start = 2;
+	else if (!startPath.empty() && path.size() > startPath.size() && path[startPath.size()] == '/' && path.compare(0, startPath.size(), startPath) == 0)
+		start = startPath.size() + 1;
+	else
+		return false;
 
-	if(Settings::getInstance()->getBool("IgnoreGamelist"))
-		return;
+	while (start <= path.size())
+	{
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+			end = path.size();
+
+		size_t length = end - start;
+		if (length == 0 || (length == 1 && path[start] == '.') || (length == 2 && path[start] == '.' && path[start + 1] == '.'))
+			return false;
 
+		start = end + 1;
+	}
+
+	return true;
+}
+
+static size_t writeGamelist(GamelistChanges& changes)
+{
 	int numUpdated = 0;
 
 	pugi::xml_document doc;
 	pugi::xml_node root;
-	std::string xmlReadPath = system->getGamelistPath(false);
+	const std::string& xmlReadPath = changes.readPath;
 
 	if (Utils::FileSystem::exists(xmlReadPath))
 	{
@@ -240,117 +344,233 @@ void updateGamelist(SystemData* system)
 		if(!result)
 		{
 			LOG(LogError) << "Error parsing XML file \"" << xmlReadPath << "\"!\n	" << result.description();
-			return;
+			return 0;
 		}
 
 		root = doc.child("gameList");		
 		if(!root)
 		{
 			LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlReadPath << "\"!";
-			return;
+			return 0;
 		}
 	}else{
 		//set up an empty gamelist to append to
 		root = doc.append_child("gameList");
 	}
 
+	// Index the existing nodes once by their path as written, that's how we write them too.
+	// Paths written differently ("a/../b", "~/"...) are matched through their canonical form : only those nodes
+	// are canonicalized, and only if a changed file can't be found by its written path.
+	typedef std::unordered_map<std::string, pugi::xml_node> NodeIndex;
 
-	//now we have all the information from the XML. now iterate through all our games and add information from there
-	FolderData* rootFolder = system->getRootFolder();
-	if (rootFolder != nullptr)
+	NodeIndex pathIndex[2];
+	NodeIndex canonicalIndex[2];
+	std::vector<std::pair<int, NodeIndex::value_type>> unnormalizedNodes;
+	bool canonicalIndexed = false;
+
+	std::unordered_set<pugi::xml_node_struct*> removedNodes;
+
+	for (pugi::xml_node fileNode : root.children())
 	{
-		//get only files, no folders
-		std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
-		//iterate through all files, checking if they're already in the XML
-		for(std::vector<FileData*>::const_iterator fit = files.cbegin(); fit != files.cend(); ++fit)
+		std::string tag = fileNode.name();
+		if (tag != "game" && tag != "folder")
+			continue;
+
+		pugi::xml_node pathNode = fileNode.child("path");
+		if (!pathNode)
 		{
-			const char* tag = ((*fit)->getType() == GAME) ? "game" : "folder";
+			LOG(LogError) << "<" << tag << "> node contains no <path> child!";
+			continue;
+		}
 
-			// do not touch if it wasn't changed anyway
-			if (!(*fit)->metadata.wasChanged())
-				continue;
+		// the first node wins when a path is listed twice
+		int index = tag == "game" ? 0 : 1;
+		auto inserted = pathIndex[index].emplace(Utils::FileSystem::getGenericPath(pathNode.text().get()), fileNode);
+		if (inserted.second && !isNormalizedPath(inserted.first->first, changes.startPath))
+			unnormalizedNodes.push_back(std::make_pair(index, *inserted.first));
+	}
 
-			bool removed = false;
+	auto buildCanonicalIndex = [&]()
+	{
+		for (auto it = unnormalizedNodes.cbegin(); it != unnormalizedNodes.cend(); ++it)
+			canonicalIndex[it->first].emplace(Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(it->second.first, changes.startPath, true)), it->second.second);
 
-			// check if the file already exists in the XML
-			// if it does, remove it before adding
-			for(pugi::xml_node fileNode = root.child(tag); fileNode; fileNode = fileNode.next_sibling(tag))
-			{
-				pugi::xml_node pathNode = fileNode.child("path");
-				if(!pathNode)
-				{
-					LOG(LogError) << "<" << tag << "> node contains no <path> child!";
-					continue;
-				}
+		unnormalizedNodes.clear();
+		canonicalIndexed = true;
+	};
 
-				std::string nodePath = Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(pathNode.text().get(), system->getStartPath(), true));
-				std::string gamePath = Utils::FileSystem::getCanonicalPath((*fit)->getPath());
-				if(nodePath == gamePath)
-				{
-					// found it
-					removed = true;
-					root.remove_child(fileNode);					
-					break;
-				}
+	//now we have all the information from the XML. now iterate through all our changed games and add information from there
+	for (auto fit = changes.entries.cbegin(); fit != changes.entries.cend(); ++fit)
+	{
+		int index = fit->index;
+		pugi::xml_node fileNode;
+
+		// check if the file already exists in the XML
+		auto it = pathIndex[index].find(fit->writtenPath);
+		if (it == pathIndex[index].end())
+			it = pathIndex[index].find(fit->fullPath);
+
+		if (it != pathIndex[index].end())
+		{
+			fileNode = it->second;
+			pathIndex[index].erase(it);
+		}
+		else if (!unnormalizedNodes.empty() || !canonicalIndex[index].empty())
+		{
+			if (!canonicalIndexed)
+				buildCanonicalIndex();
+
+			// only the changed file is canonicalized, the index holds the few nodes written differently
+			auto cit = canonicalIndex[index].find(Utils::FileSystem::getCanonicalPath(fit->fullPath));
+			if (cit != canonicalIndex[index].end())
+			{
+				fileNode = cit->second;
+				canonicalIndex[index].erase(cit);
 			}
+		}
 
-			// it was either removed or never existed to begin with; either way, we can add it now
-			if (addFileDataNode(root, *fit, tag, system))
-				++numUpdated; // Only if really added
-			else if (removed)
-				++numUpdated; // Only if really removed
+		// if it does, remove it before adding, a node can be reached from both indexes
+		bool removed = false;
+		if (fileNode && removedNodes.insert(fileNode.internal_object()).second)
+		{
+			removed = true;
+			root.remove_child(fileNode);
 		}
 
-		//now write the file
+		// it was either removed or never existed to begin with; either way, we can add it now
+		if (fit->node)
+		{
+			root.append_copy(fit->node);
+			++numUpdated; // Only if really added
+		}
+		else if (removed)
+			++numUpdated; // Only if really removed
+	}
 
-		if (numUpdated > 0) {
-			//make sure the folders leading up to this path exist (or the write will fail)
-			std::string xmlWritePath(system->getGamelistPath(true));
-			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
+	//now write the file
 
-			LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
+	if (numUpdated == 0)
+		return 0;
 
-			// Secure XML writing -> Write to a temporary file first
-			std::string tmpFile = xmlWritePath + ".tmp";
-			if (Utils::FileSystem::exists(tmpFile))
-				Utils::FileSystem::removeFile(tmpFile);
+	size_t bytesWritten = 0;
 
-			if (!doc.save_file(tmpFile.c_str())) {
-				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-			}
-			else if (Utils::FileSystem::exists(tmpFile))
-			{				
-				doc.reset();
+	//make sure the folders leading up to this path exist (or the write will fail)
+	const std::string& xmlWritePath = changes.writePath;
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
 
-#ifdef WIN32
-				::Sleep(50); // Introduce a small sleep
-#endif
+	LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
-				// Secure XML writing
-				if (Utils::FileSystem::getFileSize(tmpFile) != 0)
-				{
-					std::string savFile = xmlWritePath + ".old";
+	// Secure XML writing -> Write to a temporary file first
+	std::string tmpFile = xmlWritePath + ".tmp";
+	if (Utils::FileSystem::exists(tmpFile))
+		Utils::FileSystem::removeFile(tmpFile);
 
-					// remove previous gamelist.xml.old file
-					if (Utils::FileSystem::exists(savFile))
-						Utils::FileSystem::removeFile(savFile);					
+	if (!doc.save_file(tmpFile.c_str())) {
+		LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << changes.systemName << ")!";
+	}
+	else if (Utils::FileSystem::exists(tmpFile))
+	{				
+		std::string snapshot;
+		if (changes.writeSnapshot)
+			snapshot = GamelistSnapshot::build(root);
 
-					// rename gamelist.xml to gamelist.xml.old
-					if (Utils::FileSystem::exists(xmlWritePath))
-						std::rename(xmlWritePath.c_str(), savFile.c_str());
-					else
-						LOG(LogError) << "Unable to rename \"" << xmlWritePath << "to " << savFile << "\"!";
+		doc.reset();
 
-					// rename gamelist.tmp.xml to gamelist.xml
-					if (std::rename(tmpFile.c_str(), xmlWritePath.c_str()) != 0)
-						LOG(LogError) << "Unable to rename \"" << tmpFile << "to " << xmlWritePath << "\"!";
+#ifdef WIN32
+		::Sleep(50); // Introduce a small sleep
+#endif
 
-				}
-				else 
-					Utils::FileSystem::removeFile(tmpFile);
-			}
+		// Secure XML writing
+		bytesWritten = Utils::FileSystem::getFileSize(tmpFile);
+		if (bytesWritten != 0)
+		{
+			std::string savFile = xmlWritePath + ".old";
+
+			// remove previous gamelist.xml.old file
+			if (Utils::FileSystem::exists(savFile))
+				Utils::FileSystem::removeFile(savFile);					
+
+			// rename gamelist.xml to gamelist.xml.old
+			if (Utils::FileSystem::exists(xmlWritePath))
+				std::rename(xmlWritePath.c_str(), savFile.c_str());
+			else
+				LOG(LogError) << "Unable to rename \"" << xmlWritePath << "to " << savFile << "\"!";
+
+			// rename gamelist.tmp.xml to gamelist.xml
+			if (std::rename(tmpFile.c_str(), xmlWritePath.c_str()) != 0)
+				LOG(LogError) << "Unable to rename \"" << tmpFile << "to " << xmlWritePath << "\"!";
+			else if (!snapshot.empty())
+				GamelistSnapshot::write(xmlWritePath, snapshot);
 		}
-	}else{
+		else 
+			Utils::FileSystem::removeFile(tmpFile);
+	}
+
+	return bytesWritten;
+}
+
+static PersistenceManager::WriteFunction captureGamelist(SystemData* system)
+{
+	if(Settings::getInstance()->getBool("IgnoreGamelist"))
+		return nullptr;
+
+	FolderData* rootFolder = system->getRootFolder();
+	if (rootFolder == nullptr)
+	{
 		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
+		return nullptr;
 	}
+
+	std::shared_ptr<GamelistChanges> changes = std::make_shared<GamelistChanges>();
+
+	// only the changed files are written
+	pugi::xml_node scratch = changes->doc.append_child("gameList");
+
+	std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
+	for (auto it = files.cbegin(); it != files.cend(); ++it)
+	{
+		FileData* file = *it;
+
+		// do not touch if it wasn't changed anyway
+		if (!file->metadata.wasChanged())
+			continue;
+
+		GamelistChanges::Entry entry;
+		entry.index = (file->getType() == GAME) ? 0 : 1;
+		entry.fullPath = file->getPath();
+		entry.writtenPath = Utils::FileSystem::createRelativePath(entry.fullPath, system->getStartPath(), false);
+
+		if (addFileDataNode(scratch, file, entry.index == 0 ? "game" : "folder", system))
+			entry.node = scratch.last_child();
+
+		changes->entries.push_back(entry);
+	}
+
+	// don't even read the XML if there is nothing to write
+	if (changes->entries.empty())
+		return nullptr;
+
+	changes->systemName = system->getName();
+	changes->startPath = system->getStartPath();
+	changes->readPath = system->getGamelistPath(false);
+	changes->writePath = system->getGamelistPath(true);
+	changes->writeSnapshot = Settings::getInstance()->getBool("GamelistSnapshot");
+
+	return [changes]() { return writeGamelist(*changes); };
+}
+
+void updateGamelist(SystemData* system)
+{
+	PROFILE_SCOPE("Gamelist::update");
+
+	//We do this by reading the XML again, adding changes and then writing it back,
+	//because there might be information missing in our systemdata which would then miss in the new XML.
+	//We have the complete information for every game though, so we can simply remove a game
+	//we already have in the system from the XML, and then add it back from its GameData information...
+
+	if(Settings::getInstance()->getBool("IgnoreGamelist"))
+		return;
+
+	// the changes are captured once the system stops changing, then written in the background
+	PersistenceManager::getInstance()->markDirty("gamelist " + system->getName(), [system] { return captureGamelist(system); });
 }
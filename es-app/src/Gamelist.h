@@ -2,13 +2,31 @@
 #ifndef ES_APP_GAME_LIST_H
 #define ES_APP_GAME_LIST_H
 
+#include "GamelistSnapshot.h"
+#include <pugixml/src/pugixml.hpp>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 class SystemData;
 class FileData;
 
-// Loads gamelist.xml data into a SystemData.
-void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+// A gamelist read from its xml or snapshot. load() doesn't touch the system's tree so it can run
+// while the rom folders are scanned, apply() then merges the entries with the scanned files.
+class GamelistFile
+{
+public:
+	GamelistFile();
+
+	bool load(SystemData* system);
+	void apply(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+
+private:
+	std::string					mPath;
+	pugi::xml_document			mDoc;
+	GamelistSnapshot			mSnapshot;
+	std::vector<GamelistEntry>	mEntries; // point into mDoc or mSnapshot
+};
 
 // Writes currently loaded metadata for a SystemData to gamelist.xml.
 void updateGamelist(SystemData* system);
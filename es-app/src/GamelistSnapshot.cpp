@@ -0,0 +1,307 @@
+#include "GamelistSnapshot.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <pugixml/src/pugixml.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_MAGIC		"ESGL"
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_NO_STRING	0xFFFFFFFF
+
+struct SnapshotHeader
+{
+	char		magic[4];
+	uint32_t	version;
+	uint32_t	fieldCount;		// MetaDataId::Count when the snapshot was built
+	uint32_t	recordCount;
+	int64_t		sourceTime;		// gamelist.xml modification time
+	uint64_t	sourceSize;		// gamelist.xml size
+	uint32_t	stringsSize;
+	uint32_t	reserved;
+};
+
+struct SnapshotRecord
+{
+	uint32_t	type;
+	uint32_t	path;
+	uint32_t	values[MetaDataId::Count]; // offsets in the string table
+};
+
+GamelistSnapshot::GamelistSnapshot() : mData(nullptr), mSize(0), mRecordCount(0), mStrings(nullptr)
+{
+#if defined(_WIN32)
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+#endif
+}
+
+GamelistSnapshot::~GamelistSnapshot()
+{
+	close();
+}
+
+std::string GamelistSnapshot::getSnapshotPath(const std::string& xmlPath)
+{
+	return Utils::FileSystem::getParent(xmlPath) + "/gamelist.snapshot";
+}
+
+bool GamelistSnapshot::open(const std::string& xmlPath)
+{
+	close();
+
+	long long sourceTime = Utils::FileSystem::getModificationTime(xmlPath);
+	size_t sourceSize = Utils::FileSystem::getFileSize(xmlPath);
+
+	std::string path = getSnapshotPath(xmlPath);
+
+#if defined(_WIN32)
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart < (LONGLONG) sizeof(SnapshotHeader))
+	{
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMapping(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mData = (const char*) MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	mSize = (size_t) fileSize.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(SnapshotHeader))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps its own reference
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mData = (const char*) data;
+	mSize = (size_t) info.st_size;
+#endif
+
+	if (mData == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	SnapshotHeader header;
+	memcpy(&header, mData, sizeof(header));
+
+	if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION || header.fieldCount != MetaDataId::Count)
+	{
+		LOG(LogInfo) << "Ignoring gamelist snapshot with unknown format : " << path;
+		close();
+		return false;
+	}
+
+	if (header.sourceTime != sourceTime || header.sourceSize != sourceSize)
+	{
+		LOG(LogInfo) << "Gamelist snapshot is out of date : " << path;
+		close();
+		return false;
+	}
+
+	size_t expectedSize = sizeof(SnapshotHeader) + (size_t) header.recordCount * sizeof(SnapshotRecord) + header.stringsSize;
+	if (expectedSize != mSize || header.stringsSize == 0 || mData[mSize - 1] != 0)
+	{
+		LOG(LogWarning) << "Ignoring corrupted gamelist snapshot : " << path;
+		close();
+		return false;
+	}
+
+	mRecordCount = header.recordCount;
+	mStrings = mData + mSize - header.stringsSize;
+	return true;
+}
+
+void GamelistSnapshot::close()
+{
+#if defined(_WIN32)
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+#else
+	if (mData != nullptr)
+		munmap((void*) mData, mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+	mRecordCount = 0;
+	mStrings = nullptr;
+}
+
+void GamelistSnapshot::getEntry(size_t index, GamelistEntry& entry) const
+{
+	SnapshotRecord record;
+	memcpy(&record, mData + sizeof(SnapshotHeader) + index * sizeof(SnapshotRecord), sizeof(record));
+
+	size_t stringsSize = (mData + mSize) - mStrings;
+
+	// the table ends with a null char, any offset inside it is a valid string
+	auto getString = [this, stringsSize](uint32_t offset) -> const char*
+	{
+		return offset < stringsSize ? mStrings + offset : nullptr;
+	};
+
+	entry.type = (record.type == FOLDER ? FOLDER : GAME);
+	entry.path = getString(record.path);
+	if (entry.path == nullptr)
+		entry.path = "";
+
+	for (int i = 0; i < MetaDataId::Count; i++)
+		entry.values[i] = getString(record.values[i]);
+}
+
+std::string GamelistSnapshot::build(const pugi::xml_node& root)
+{
+	std::vector<SnapshotRecord> records;
+	std::string strings;
+	std::unordered_map<std::string, uint32_t> stringIndex;
+
+	// genres, developers or dates come back a lot, store them once
+	auto addString = [&strings, &stringIndex](const char* value) -> uint32_t
+	{
+		auto it = stringIndex.find(value);
+		if (it != stringIndex.end())
+			return it->second;
+
+		uint32_t offset = (uint32_t) strings.size();
+		strings.append(value);
+		strings.push_back(0);
+		stringIndex[value] = offset;
+		return offset;
+	};
+
+	for (pugi::xml_node fileNode : root.children())
+	{
+		std::string tag = fileNode.name();
+
+		FileType type = GAME;
+		if (tag == "folder")
+			type = FOLDER;
+		else if (tag != "game")
+			continue;
+
+		SnapshotRecord record;
+		record.type = type;
+		record.path = addString(fileNode.child("path").text().get());
+
+		for (int i = 0; i < MetaDataId::Count; i++)
+			record.values[i] = SNAPSHOT_NO_STRING;
+
+		// folders are read with the game declarations as well, see GamelistFile::apply and loadGamelistEntry
+		const std::vector<MetaDataDecl>& mdd = getMDDByType(GAME_METADATA);
+		for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
+		{
+			pugi::xml_node md = fileNode.child(iter->key.c_str());
+			if (md)
+				record.values[iter->id] = addString(md.text().get());
+		}
+
+		records.push_back(record);
+	}
+
+	if (strings.empty())
+		strings.push_back(0);
+
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+	header.version = SNAPSHOT_VERSION;
+	header.fieldCount = MetaDataId::Count;
+	header.recordCount = (uint32_t) records.size();
+	header.stringsSize = (uint32_t) strings.size();
+
+	std::string data;
+	data.reserve(sizeof(header) + records.size() * sizeof(SnapshotRecord) + strings.size());
+	data.append((const char*) &header, sizeof(header));
+	if (!records.empty())
+		data.append((const char*) records.data(), records.size() * sizeof(SnapshotRecord));
+	data.append(strings);
+	return data;
+}
+
+bool GamelistSnapshot::write(const std::string& xmlPath, const std::string& data)
+{
+	if (data.size() < sizeof(SnapshotHeader))
+		return false;
+
+	// tie the snapshot to the xml it was built from
+	SnapshotHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	header.sourceTime = Utils::FileSystem::getModificationTime(xmlPath);
+	header.sourceSize = Utils::FileSystem::getFileSize(xmlPath);
+
+	std::string path = getSnapshotPath(xmlPath);
+	std::string tmpPath = path + ".tmp";
+
+	std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG(LogDebug) << "Unable to write gamelist snapshot : " << tmpPath;
+		return false;
+	}
+
+	file.write((const char*) &header, sizeof(header));
+	file.write(data.data() + sizeof(header), data.size() - sizeof(header));
+	file.close();
+
+	if (file.fail())
+	{
+		LOG(LogError) << "Error writing gamelist snapshot : " << tmpPath;
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	Utils::FileSystem::removeFile(path);
+	if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "Unable to rename gamelist snapshot : " << tmpPath;
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	return true;
+}
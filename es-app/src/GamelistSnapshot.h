@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_SNAPSHOT_H
+#define ES_APP_GAMELIST_SNAPSHOT_H
+
+#include "FileData.h"
+#include "MetaData.h"
+#include <string>
+
+namespace pugi { class xml_node; }
+
+// One <game> or <folder> node of a gamelist, pointers stay valid as long as their source does
+struct GamelistEntry
+{
+	FileType type;
+	const char* path;
+	const char* values[MetaDataId::Count]; // raw texts indexed by MetaDataId, nullptr when missing
+};
+
+// Binary copy of a gamelist.xml : a header, fixed size records and a string table, memory mapped when loading.
+// The xml stays the reference, a snapshot is only used while the xml modification time and size match the ones it was built from.
+class GamelistSnapshot
+{
+public:
+	GamelistSnapshot();
+	~GamelistSnapshot();
+
+	// Maps the snapshot of xmlPath, fails if it's missing, invalid or older than the xml
+	bool open(const std::string& xmlPath);
+	void close();
+
+	size_t size() const { return mRecordCount; }
+	void getEntry(size_t index, GamelistEntry& entry) const;
+
+	// Serializes the <game> and <folder> nodes of a gameList node, the result is written with write()
+	static std::string build(const pugi::xml_node& root);
+	static bool write(const std::string& xmlPath, const std::string& data);
+
+	static std::string getSnapshotPath(const std::string& xmlPath);
+
+private:
+	const char* mData;
+	size_t mSize;
+	size_t mRecordCount;
+	const char* mStrings;
+
+#if defined(_WIN32)
+	void* mFile;
+	void* mMapping;
+#endif
+};
+
+#endif // ES_APP_GAMELIST_SNAPSHOT_H
@@ -1,114 +1,161 @@
 #include "MetaData.h"
 
+#include "FileData.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/StringPool.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
 #include <pugixml/src/pugixml.hpp>
 #include "SystemData.h"
 #include "Settings.h"
+#include <atomic>
+#include <climits>
+#include <string.h>
 
 MetaDataDecl gameDecls[] = {
-	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
-	{ 0,  "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-//	{ 1,  "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{ 2,  "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{ 3,  "emulator",    MD_PLIST,				 "",                 false,      "emulator",			 "emulator" },
-	{ 4,  "core",	     MD_PLIST,				 "",                 false,      "core",				 "core" },	
-	{ 5,  "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{ 6,  "video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
-	{ 7,  "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{ 8,  "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{ 9,  "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
-	{ 10, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{ 11, "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{ 12, "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{ 13, "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{ 14, "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{ 15, "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
-	{ 16, "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
-	{ 17, "kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
-	{ 18, "playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
-	{ 19, "lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
+	// id,                      key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
+	{ MetaDataId::Name,         "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+//	{ MetaDataId::SortName,     "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{ MetaDataId::Desc,         "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{ MetaDataId::Emulator,     "emulator",    MD_PLIST,				 "",                 false,      "emulator",			 "emulator" },
+	{ MetaDataId::Core,         "core",	     MD_PLIST,				 "",                 false,      "core",				 "core" },	
+	{ MetaDataId::Image,        "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{ MetaDataId::Video,        "video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
+	{ MetaDataId::Marquee,      "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{ MetaDataId::Thumbnail,    "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{ MetaDataId::Rating,       "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
+	{ MetaDataId::ReleaseDate,  "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{ MetaDataId::Developer,    "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{ MetaDataId::Publisher,    "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{ MetaDataId::Genre,        "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{ MetaDataId::Players,      "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{ MetaDataId::Favorite,     "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
+	{ MetaDataId::Hidden,       "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{ MetaDataId::KidGame,      "kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
+	{ MetaDataId::PlayCount,    "playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
+	{ MetaDataId::LastPlayed,   "lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
 };
 
 const std::vector<MetaDataDecl> gameMDD(gameDecls, gameDecls + sizeof(gameDecls) / sizeof(gameDecls[0]));
 
 MetaDataDecl folderDecls[] = {
-	{ 0,  "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-//	{ 1,  "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{ 2,  "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{ 3,  "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{ 4,  "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{ 5,  "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
-	{ 6,  "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{ 7,  "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
-	{ 8,  "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{ 9,  "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{ 10, "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{ 11, "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{ 12, "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{ 13, "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on" },
-	{ 14, "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{ MetaDataId::Name,         "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+//	{ MetaDataId::SortName,     "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{ MetaDataId::Desc,         "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{ MetaDataId::Image,        "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{ MetaDataId::Thumbnail,    "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{ MetaDataId::Video,        "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{ MetaDataId::Marquee,      "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{ MetaDataId::Rating,       "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
+	{ MetaDataId::ReleaseDate,  "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{ MetaDataId::Developer,    "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{ MetaDataId::Publisher,    "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{ MetaDataId::Genre,        "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{ MetaDataId::Players,      "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{ MetaDataId::Favorite,     "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on" },
+	{ MetaDataId::Hidden,       "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
 };
 
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
-std::map<std::string, unsigned char> MetaDataList::mGameIdMap = MetaDataList::BuildIdMap(GAME_METADATA);
-std::map<std::string, unsigned char> MetaDataList::mFolderIdMap = MetaDataList::BuildIdMap(FOLDER_METADATA);
+std::vector<const MetaDataDecl*> MetaDataList::mGameDecls = MetaDataList::BuildDeclTable(GAME_METADATA);
+std::vector<const MetaDataDecl*> MetaDataList::mFolderDecls = MetaDataList::BuildDeclTable(FOLDER_METADATA);
 
-std::map<unsigned char, MetaDataType> MetaDataList::mGameTypeMap = MetaDataList::BuildTypeMap(GAME_METADATA);
-std::map<unsigned char, MetaDataType> MetaDataList::mFolderTypeMap = MetaDataList::BuildTypeMap(FOLDER_METADATA);
+std::unordered_map<std::string, MetaDataId::Id> MetaDataList::mIdMap = MetaDataList::BuildIdMap();
 
-std::map<unsigned char, std::string> MetaDataList::mDefaultGameMap = MetaDataList::BuildDefaultMap(GAME_METADATA);
-std::map<unsigned char, std::string> MetaDataList::mDefaultFolderMap = MetaDataList::BuildDefaultMap(FOLDER_METADATA);
+// Strings with few distinct values (developer, genre, emulator...) are only allocated once and referenced from
+// every list using them. The name, the description and the paths are unique per game and are not interned.
+static const std::string* internString(const std::string& value)
+{
+	return Utils::StringPool::getInstance()->intern(value);
+}
 
-std::map<unsigned char, MetaDataType> MetaDataList::BuildTypeMap(MetaDataListType type)
+// Dates are stored as ISO strings (YYYYMMDDTHHMMSS) -> YYYYMMDDhhmmss
+static bool parseDate(const std::string& value, long long& date)
 {
-	std::map<unsigned char, MetaDataType> ret;
+	if (value.size() != 15 || value[8] != 'T')
+		return false;
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->type;
+	long long ret = 0;
 
-	return ret;
+	for (int i = 0; i < 15; i++)
+	{
+		if (i == 8)
+			continue;
+
+		char c = value[i];
+		if (c < '0' || c > '9')
+			return false;
+
+		ret = ret * 10 + (c - '0');
+	}
+
+	date = ret;
+	return true;
 }
 
-std::map<std::string, unsigned char> MetaDataList::BuildIdMap(MetaDataListType type)
+static std::string formatDate(long long date)
 {
-	std::map<std::string, unsigned char> ret;
+	char buffer[16];
+	buffer[15] = 0;
+
+	for (int i = 14; i >= 0; i--)
+	{
+		if (i == 8)
+		{
+			buffer[i] = 'T';
+			continue;
+		}
+
+		buffer[i] = '0' + (char)(date % 10);
+		date /= 10;
+	}
+
+	return buffer;
+}
+
+std::vector<const MetaDataDecl*> MetaDataList::BuildDeclTable(MetaDataListType type)
+{
+	std::vector<const MetaDataDecl*> ret(MetaDataId::Count, nullptr);
 
 	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
 	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->key] = iter->id;
+		ret[iter->id] = &(*iter);
 
 	return ret;
 }
 
-std::map<unsigned char, std::string> MetaDataList::BuildDefaultMap(MetaDataListType type)
+std::unordered_map<std::string, MetaDataId::Id> MetaDataList::BuildIdMap()
 {
-	std::map<unsigned char, std::string> ret;
+	std::unordered_map<std::string, MetaDataId::Id> ret;
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->defaultValue;		
+	for (auto iter = gameMDD.cbegin(); iter != gameMDD.cend(); iter++)
+		ret[iter->key] = iter->id;
+
+	for (auto iter = folderMDD.cbegin(); iter != folderMDD.cend(); iter++)
+		ret[iter->key] = iter->id;
 
 	return ret;
 }
 
-MetaDataType MetaDataList::getType(unsigned char id) const
+MetaDataId::Id MetaDataList::getId(const std::string& key)
 {
-	if (mType == GAME_METADATA)
-		return mGameTypeMap[id];
+	auto it = mIdMap.find(key);
+	if (it == mIdMap.cend())
+		return MetaDataId::Count;
 
-	return mFolderTypeMap[id];
+	return it->second;
 }
 
-unsigned char MetaDataList::getId(const std::string& key) const
+const MetaDataDecl* MetaDataList::getDecl(MetaDataId::Id id) const
 {
+	if (id >= MetaDataId::Count)
+		return nullptr;
+
 	if (mType == GAME_METADATA)
-		return mGameIdMap[key];
+		return mGameDecls[id];
 
-	return mFolderIdMap[key];
+	return mFolderDecls[id];
 }
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
@@ -125,40 +172,69 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 	return gameMDD;
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
-{ 
+static std::atomic<unsigned int> sNextVersion(0);
+
+MetaDataList::Owner& MetaDataList::Owner::operator=(const Owner&)
+{
+	if (file != nullptr)
+		file->onMetadataChanged();
+
+	return *this;
+}
+
+void MetaDataList::changed()
+{
+	mWasChanged = true;
+	mVersion = ++sNextVersion;
 
+	if (mOwner.file != nullptr)
+		mOwner.file->onMetadataChanged();
+}
+
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mVersion(++sNextVersion), mRelativeTo(nullptr), mSetMask(0), mRawMask(0)
+{ 
+	memset(mValues, 0, sizeof(mValues));
 }
 
 MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system)
+{
+	const char* values[MetaDataId::Count] = { };
+
+	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
+
+	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
+	{
+		pugi::xml_node md = node.child(iter->key.c_str());
+		if (md)
+			values[iter->id] = md.text().get();
+	}
+
+	return createFromValues(type, values, system);
+}
+
+MetaDataList MetaDataList::createFromValues(MetaDataListType type, const char* const* values, SystemData* system)
 {
 	MetaDataList mdl(type);
 	mdl.mRelativeTo = system;
 
-	auto sz = sizeof(MetaDataList);
-
 	const std::vector<MetaDataDecl>& mdd = mdl.getMDD();
 
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
 	{
-		pugi::xml_node md = node.child(iter->key.c_str());
-		if (md)
-		{			
-			std::string value = md.text().get();
+		if (values[iter->id] != nullptr)
+		{
+			std::string value = values[iter->id];
 
-		//	if (iter->type == MD_PATH) // if it's a path, resolve relative paths
-		//		value = Utils::FileSystem::resolveRelativePath(value, relativeTo, true);
+			if (iter->type == MD_BOOL)
+				value = Utils::String::toLower(value);
 
 			if (value == iter->defaultValue)
 				continue;
-			
-			if (iter->type == MD_BOOL)
-				value = Utils::String::toLower(value);
 
-			if (iter->id == 0)
-				mdl.mName = value;
+			if (iter->id == MetaDataId::Name)
+				mdl.mName = std::make_shared<const std::string>(value);
 			else
-				mdl.mMap[iter->id] = value;
+				mdl.setValue(&(*iter), value);
 		}
 	}
 
@@ -171,88 +247,278 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 
 	for(auto mddIter = mdd.cbegin(); mddIter != mdd.cend(); mddIter++)
 	{
-		if (mddIter->id == 0)
+		if (mddIter->id == MetaDataId::Name)
 		{
-			parent.append_child("name").text().set(mName.c_str());
+			parent.append_child("name").text().set(mName != nullptr ? mName->c_str() : "");
 			continue;
 		}
 
-		auto mapIter = mMap.find(mddIter->id);
-		if (mapIter != mMap.cend())
-		{
-			// we have this value!
-			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
-				continue;
-			
-			// try and make paths relative if we can
-			std::string value = mapIter->second;
-			if (mddIter->type == MD_PATH)
-				value = Utils::FileSystem::createRelativePath(value, relativeTo, true);
+		if (!isSet(mddIter->id))
+			continue;
 
-			parent.append_child(mddIter->key.c_str()).text().set(value.c_str()); // mapIter->first
-		}
+		// we have this value!
+		std::string value = getValue(&(*mddIter));
+
+		// if it's just the default (and we ignore defaults), don't write it
+		if (ignoreDefaults && value == mddIter->defaultValue)
+			continue;
+
+		// try and make paths relative if we can
+		if (mddIter->type == MD_PATH)
+			value = Utils::FileSystem::createRelativePath(value, relativeTo, true);
+
+		parent.append_child(mddIter->key.c_str()).text().set(value.c_str());
 	}
 }
 
 const std::string& MetaDataList::getName() const
 {
-	return mName;
+	static const std::string empty;
+	return mName != nullptr ? *mName : empty;
 }
 
-void MetaDataList::set(const std::string& key, const std::string& value)
+void MetaDataList::setValue(const MetaDataDecl* decl, const std::string& value)
 {
-	if (key == "name")
+	unsigned int bit = 1u << decl->id;
+	Value& slot = mValues[decl->id];
+
+	mSetMask |= bit;
+
+	if (decl->id == MetaDataId::Desc)
 	{
-		if (mName == value)
-			return;
+		mDesc = std::make_shared<const std::string>(value);
+		mRawMask &= ~bit;
+		return;
+	}
 
-		mName = value;
+	if (decl->type == MD_PATH)
+	{
+		// Paths under the system folder are kept relative to it : get() resolves them, and the lists don't store
+		// the same "/home/pi/RetroPie/roms/<system>/" prefix for every media
+		const std::string startPath = mRelativeTo != nullptr ? mRelativeTo->getStartPath() : "";
+
+		if (!startPath.empty() && value.size() > startPath.size() + 1 && value[startPath.size()] == '/' && value.compare(0, startPath.size(), startPath) == 0)
+			getPathSlot(decl->id) = std::make_shared<const std::string>("." + value.substr(startPath.size()));
+		else
+			getPathSlot(decl->id) = std::make_shared<const std::string>(value);
+
+		mRawMask |= bit;
+		return;
+	}
+
+	bool native = false;
+
+	switch (decl->type)
+	{
+	case MD_INT:
+		slot.intValue = atoi(value.c_str());
+		native = (std::to_string(slot.intValue) == value);
+		break;
+
+	case MD_FLOAT:
+	case MD_RATING:
+		slot.floatValue = (float)atof(value.c_str());
+		native = (std::to_string(slot.floatValue) == value);
+		break;
+
+	case MD_BOOL:
+		slot.boolValue = (value == "true");
+		native = (slot.boolValue || value == "false");
+		break;
+
+	case MD_DATE:
+	case MD_TIME:
+		native = parseDate(value, slot.dateValue);
+		break;
 	}
+
+	if (native)
+		mRawMask &= ~bit;
 	else
 	{
-		auto id = getId(key);
-		
-		auto prev = mMap.find(id);
-		if (prev != mMap.cend() && prev->second == value)
+		slot.stringValue = internString(value);
+		mRawMask |= bit;
+	}
+}
+
+std::string MetaDataList::getValue(const MetaDataDecl* decl) const
+{
+	MetaDataId::Id id = decl->id;
+
+	if (!isSet(id))
+		return decl->defaultValue;
+
+	if (id == MetaDataId::Desc)
+		return mDesc != nullptr ? *mDesc : "";
+
+	if (decl->type == MD_PATH)
+		return *getPathSlot(id);
+
+	if (isRaw(id))
+		return *mValues[id].stringValue;
+
+	switch (decl->type)
+	{
+	case MD_INT:
+		return std::to_string(mValues[id].intValue);
+
+	case MD_FLOAT:
+	case MD_RATING:
+		return std::to_string(mValues[id].floatValue);
+
+	case MD_BOOL:
+		return mValues[id].boolValue ? "true" : "false";
+
+	case MD_DATE:
+	case MD_TIME:
+		return formatDate(mValues[id].dateValue);
+	}
+
+	return decl->defaultValue;
+}
+
+void MetaDataList::set(MetaDataId::Id id, const std::string& value)
+{
+	if (id == MetaDataId::Name)
+	{
+		if (getName() == value)
 			return;
 
-		mMap[id] = value;
+		if (value.empty())
+			mName.reset();
+		else
+			mName = std::make_shared<const std::string>(value);
+
+		changed();
+		return;
 	}
 
-	mWasChanged = true;
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl == nullptr)
+		return;
+
+	if ((decl->type == MD_PATH ? get(id) : getValue(decl)) == value)
+		return;
+
+	if (value == decl->defaultValue)
+	{
+		unsigned int bit = 1u << id;
+		mSetMask &= ~bit;
+		mRawMask &= ~bit;
+
+		if (id == MetaDataId::Desc)
+			mDesc.reset();
+		else if (decl->type == MD_PATH)
+			getPathSlot(id).reset();
+	}
+	else
+		setValue(decl, value);
+
+	changed();
 }
 
-const std::string MetaDataList::get(const std::string& key) const
+void MetaDataList::setInt(MetaDataId::Id id, int value)
+{
+	set(id, std::to_string(value));
+}
+
+void MetaDataList::setBool(MetaDataId::Id id, bool value)
+{
+	set(id, value ? "true" : "false");
+}
+
+const std::string MetaDataList::get(MetaDataId::Id id) const
 {
-	if (key == "name")
-		return mName;
+	if (id == MetaDataId::Name)
+		return getName();
 
-	auto id = getId(key);
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl == nullptr)
+		return "";
+
+	if (decl->type == MD_PATH && isSet(id) && mRelativeTo != nullptr) // if it's a path, resolve relative paths
+		return Utils::FileSystem::resolveRelativePath(*getPathSlot(id), mRelativeTo->getStartPath(), true);
+
+	return getValue(decl);
+}
+
+int MetaDataList::getInt(MetaDataId::Id id) const
+{
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl != nullptr && decl->type == MD_INT && !isRaw(id))
+		return isSet(id) ? mValues[id].intValue : atoi(decl->defaultValue.c_str());
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
-	{		
-		if (getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+	return atoi(get(id).c_str());
+}
+
+float MetaDataList::getFloat(MetaDataId::Id id) const
+{
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl != nullptr && (decl->type == MD_FLOAT || decl->type == MD_RATING) && !isRaw(id))
+		return isSet(id) ? mValues[id].floatValue : (float)atof(decl->defaultValue.c_str());
+
+	return (float)atof(get(id).c_str());
+}
+
+bool MetaDataList::getBool(MetaDataId::Id id) const
+{
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl != nullptr && decl->type == MD_BOOL && !isRaw(id))
+		return isSet(id) ? mValues[id].boolValue : (decl->defaultValue == "true");
+
+	return get(id) == "true";
+}
 
-		return it->second;
+long long MetaDataList::getDate(MetaDataId::Id id) const
+{
+	const MetaDataDecl* decl = getDecl(id);
+	if (decl != nullptr && (decl->type == MD_DATE || decl->type == MD_TIME) && isSet(id) && !isRaw(id))
+		return mValues[id].dateValue;
+
+	// partial dates (ex: "1995") are padded with zeros
+	std::string value = get(id);
+	if (value.empty() || value[0] < '0' || value[0] > '9')
+		return LLONG_MAX;
+
+	long long ret = 0;
+	int digits = 0;
+
+	for (auto c : value)
+	{
+		if (c == 'T')
+			continue;
+
+		if (c < '0' || c > '9' || digits == 14)
+			break;
+
+		ret = ret * 10 + (c - '0');
+		digits++;
 	}
 
-	if (mType == GAME_METADATA)
-		return mDefaultGameMap.at(id);
+	for (; digits < 14; digits++)
+		ret *= 10;
 
-	return mDefaultFolderMap.at(id);
+	return ret;
+}
+
+void MetaDataList::set(const std::string& key, const std::string& value)
+{
+	set(getId(key), value);
+}
+
+const std::string MetaDataList::get(const std::string& key) const
+{
+	return get(getId(key));
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	return getInt(getId(key));
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	return getFloat(getId(key));
 }
 
 bool MetaDataList::wasChanged() const
@@ -284,23 +550,23 @@ void MetaDataList::importScrappedMetadata(const MetaDataList& source)
 			type &= ~MetaDataImportType::Types::MARQUEE;
 	}
 
-	for (auto mdd : getMDD())
+	for (auto& mdd : getMDD())
 	{
-		if (mdd.key == "favorite" || mdd.key == "playcount" || mdd.key == "lastplayed")
+		if (mdd.id == MetaDataId::Favorite || mdd.id == MetaDataId::PlayCount || mdd.id == MetaDataId::LastPlayed)
 			continue;
 
-		if (mdd.key == "image" && (type & MetaDataImportType::Types::IMAGE) != MetaDataImportType::Types::IMAGE)
+		if (mdd.id == MetaDataId::Image && (type & MetaDataImportType::Types::IMAGE) != MetaDataImportType::Types::IMAGE)
 			continue;
 
-		if (mdd.key == "thumbnail" && (type & MetaDataImportType::Types::THUMB) != MetaDataImportType::Types::THUMB)
+		if (mdd.id == MetaDataId::Thumbnail && (type & MetaDataImportType::Types::THUMB) != MetaDataImportType::Types::THUMB)
 			continue;
 
-		if (mdd.key == "marquee" && (type & MetaDataImportType::Types::MARQUEE) != MetaDataImportType::Types::MARQUEE)
+		if (mdd.id == MetaDataId::Marquee && (type & MetaDataImportType::Types::MARQUEE) != MetaDataImportType::Types::MARQUEE)
 			continue;
 
-		if (mdd.key == "video" && (type & MetaDataImportType::Types::VIDEO) != MetaDataImportType::Types::VIDEO)
+		if (mdd.id == MetaDataId::Video && (type & MetaDataImportType::Types::VIDEO) != MetaDataImportType::Types::VIDEO)
 			continue;
 
-		set(mdd.key, source.get(mdd.key));
+		set(mdd.id, source.get(mdd.id));
 	}
 }
\ No newline at end of file
@@ -2,9 +2,12 @@
 #ifndef ES_APP_META_DATA_H
 #define ES_APP_META_DATA_H
 
-#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+class FileData;
 class SystemData;
 
 namespace pugi { class xml_node; }
@@ -38,9 +41,39 @@ namespace MetaDataImportType
 	};
 }
 
+// Field ids are shared by game and folder lists, a folder simply doesn't declare some of them
+namespace MetaDataId
+{
+	enum Id : unsigned char
+	{
+		Name = 0,
+		SortName = 1,
+		Desc = 2,
+		Emulator = 3,
+		Core = 4,
+		Image = 5,
+		Video = 6,
+		Marquee = 7,
+		Thumbnail = 8,
+		Rating = 9,
+		ReleaseDate = 10,
+		Developer = 11,
+		Publisher = 12,
+		Genre = 13,
+		Players = 14,
+		Favorite = 15,
+		Hidden = 16,
+		KidGame = 17,
+		PlayCount = 18,
+		LastPlayed = 19,
+
+		Count
+	};
+}
+
 struct MetaDataDecl
 {
-	unsigned char id;
+	MetaDataId::Id id;
 
 	std::string key;
 	MetaDataType type;
@@ -62,10 +95,23 @@ class MetaDataList
 {
 public:
 	static MetaDataList createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system);
+	// values are the raw texts indexed by MetaDataId, nullptr when the field is missing
+	static MetaDataList createFromValues(MetaDataListType type, const char* const* values, SystemData* system);
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
 
+	void set(MetaDataId::Id id, const std::string& value);
+	void setInt(MetaDataId::Id id, int value);
+	void setBool(MetaDataId::Id id, bool value);
+
+	const std::string get(MetaDataId::Id id) const;
+	int getInt(MetaDataId::Id id) const;
+	float getFloat(MetaDataId::Id id) const;
+	bool getBool(MetaDataId::Id id) const;
+	long long getDate(MetaDataId::Id id) const; // YYYYMMDDhhmmss, non dates are LLONG_MAX
+
+	// string keyed compatibility accessors, prefer the MetaDataId ones in new code
 	void set(const std::string& key, const std::string& value);
 
 	const std::string get(const std::string& key) const;
@@ -75,39 +121,76 @@ public:
 	bool wasChanged() const;
 	void resetChangedFlag();
 
+	// Changes with every modification, and no two lists share a version unless one is a copy of the other
+	inline unsigned int getVersion() const { return mVersion; }
+
+	// File told about every change, including another list being assigned to this one
+	inline void setOwner(FileData* owner) { mOwner.file = owner; }
+
 	inline MetaDataListType getType() const { return (MetaDataListType) mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 	const std::string& getName() const;
 
 	void importScrappedMetadata(const MetaDataList& source);
 
+	static MetaDataId::Id getId(const std::string& key);
+
 private:
-	std::string		mName;
+	// A value is stored natively when it converts back to the exact same string,
+	// otherwise (ex: "1-4" players) it's kept as a raw string.
+	union Value
+	{
+		int			intValue;
+		float		floatValue;
+		bool		boolValue;
+		long long	dateValue;		// YYYYMMDDhhmmss
+		const std::string* stringValue; // interned
+	};
+
+	// Not copied with the values : a copy belongs to another file, or to none
+	struct Owner
+	{
+		Owner() : file(nullptr) { }
+		Owner(const Owner&) : file(nullptr) { }
+		Owner& operator=(const Owner&); // the values are being replaced, the file is told
+
+		FileData* file;
+	};
+
+	Owner			mOwner;
+
+	// Values unique to each game are kept out of the pool (it never frees), but shared by the collection copies, null if empty
+	std::shared_ptr<const std::string> mName;
+	std::shared_ptr<const std::string> mDesc;
+	std::shared_ptr<const std::string> mPaths[MetaDataId::Thumbnail - MetaDataId::Image + 1]; // MD_PATH fields, Image to Thumbnail
 	unsigned char	mType;
 	bool			mWasChanged;
+	unsigned int	mVersion;
 	SystemData*		mRelativeTo;
 
-	std::map<unsigned char, std::string> mMap;
+	unsigned int	mSetMask;	// fields holding something else than their default value
+	unsigned int	mRawMask;	// fields of a native type holding a raw string
+	Value			mValues[MetaDataId::Count];
 
-	unsigned char getId(const std::string& key) const;	
-	MetaDataType getType(unsigned char id) const;
+	inline bool isSet(MetaDataId::Id id) const { return (mSetMask & (1u << id)) != 0; }
+	inline bool isRaw(MetaDataId::Id id) const { return (mRawMask & (1u << id)) != 0; }
+	inline std::shared_ptr<const std::string>& getPathSlot(MetaDataId::Id id) { return mPaths[id - MetaDataId::Image]; }
+	inline const std::shared_ptr<const std::string>& getPathSlot(MetaDataId::Id id) const { return mPaths[id - MetaDataId::Image]; }
 
+	void changed();
+	const MetaDataDecl* getDecl(MetaDataId::Id id) const;
+	void setValue(const MetaDataDecl* decl, const std::string& value);
+	std::string getValue(const MetaDataDecl* decl) const;
 
 private: // Static maps
 
-	static std::map<unsigned char, std::string> mDefaultGameMap;
-	static std::map<unsigned char, std::string> mDefaultFolderMap;
-
-	static std::map<std::string, unsigned char> mGameIdMap;
-	static std::map<std::string, unsigned char> mFolderIdMap;
-
-	static std::map<unsigned char, MetaDataType> mGameTypeMap;
-	static std::map<unsigned char, MetaDataType> mFolderTypeMap;
+	static std::vector<const MetaDataDecl*> mGameDecls;
+	static std::vector<const MetaDataDecl*> mFolderDecls;
 
-	static std::map<unsigned char, std::string> BuildDefaultMap(MetaDataListType type);
-	static std::map<std::string, unsigned char> BuildIdMap(MetaDataListType type);
-	static std::map<unsigned char, MetaDataType> BuildTypeMap(MetaDataListType type);
+	static std::unordered_map<std::string, MetaDataId::Id> mIdMap;
 
+	static std::vector<const MetaDataDecl*> BuildDeclTable(MetaDataListType type);
+	static std::unordered_map<std::string, MetaDataId::Id> BuildIdMap();
 };
 
 #endif // ES_APP_META_DATA_H
@@ -0,0 +1,280 @@
+#include "ScanCache.h"
+
+#include "Log.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#define SCAN_CACHE_MAGIC	"ESSC"
+#define SCAN_CACHE_VERSION	1
+// FAT and exFAT store times with a 2 seconds granularity : a file added in the same tick as the scan doesn't change
+// the directory time, so directories changed that recently are enumerated again at the next scan
+#define SCAN_CACHE_MTIME_GRANULARITY_NS	2000000000LL
+
+namespace
+{
+	class Reader
+	{
+	public:
+		Reader(const std::vector<char>& buffer) : mData(buffer.data()), mSize(buffer.size()), mPos(0), mValid(true) { }
+
+		bool valid() const { return mValid; }
+		bool atEnd() const { return mPos == mSize; }
+
+		template<typename T> T read()
+		{
+			T value = T();
+			if (mPos + sizeof(T) > mSize)
+			{
+				mValid = false;
+				return value;
+			}
+
+			memcpy(&value, mData + mPos, sizeof(T));
+			mPos += sizeof(T);
+			return value;
+		}
+
+		std::string readString()
+		{
+			uint32_t length = read<uint32_t>();
+			if (!mValid || mPos + length > mSize)
+			{
+				mValid = false;
+				return "";
+			}
+
+			std::string value(mData + mPos, length);
+			mPos += length;
+			return value;
+		}
+
+	private:
+		const char* mData;
+		size_t mSize;
+		size_t mPos;
+		bool mValid;
+	};
+
+	template<typename T> void write(std::string& out, T value)
+	{
+		out.append((const char*) &value, sizeof(T));
+	}
+
+	void writeString(std::string& out, const std::string& value)
+	{
+		write<uint32_t>(out, (uint32_t) value.size());
+		out.append(value);
+	}
+}
+
+ScanCache::ScanCache(const std::string& systemName) : mSystemName(systemName), mDirty(false), mHits(0), mMisses(0)
+{
+}
+
+std::string ScanCache::getCachePath(const std::string& systemName)
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/" + systemName + ".scan";
+}
+
+bool ScanCache::load()
+{
+	std::string path = getCachePath(mSystemName);
+
+	std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::vector<char> buffer((size_t) file.tellg());
+	file.seekg(0, std::ios::beg);
+	file.read(buffer.data(), buffer.size());
+	file.close();
+
+	Reader reader(buffer);
+
+	uint32_t magic = reader.read<uint32_t>();
+	uint32_t version = reader.read<uint32_t>();
+	if (!reader.valid() || memcmp(&magic, SCAN_CACHE_MAGIC, 4) != 0 || version != SCAN_CACHE_VERSION)
+	{
+		LOG(LogWarning) << "Ignoring scan cache with unknown format : " << path;
+		return false;
+	}
+
+	std::unordered_map<std::string, Directory> directories;
+
+	uint32_t dirCount = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < dirCount && reader.valid(); i++)
+	{
+		std::string dirPath = reader.readString();
+
+		Directory& dir = directories[dirPath];
+		dir.mtime = reader.read<int64_t>();
+		dir.visited = false;
+
+		uint32_t entryCount = reader.read<uint32_t>();
+		for (uint32_t e = 0; e < entryCount && reader.valid(); e++)
+		{
+			Entry entry;
+			entry.name = reader.readString();
+			entry.flags = reader.read<unsigned char>();
+			dir.entries.push_back(entry);
+		}
+	}
+
+	if (!reader.valid() || !reader.atEnd())
+	{
+		LOG(LogWarning) << "Ignoring truncated scan cache : " << path;
+		return false;
+	}
+
+	mDirectories = std::move(directories);
+	mDirty = false;
+	return true;
+}
+
+bool ScanCache::save()
+{
+	// forget the directories that were not seen during this scan
+	for (auto it = mDirectories.begin(); it != mDirectories.end(); )
+	{
+		if (!it->second.visited)
+		{
+			it = mDirectories.erase(it);
+			mDirty = true;
+		}
+		else
+			++it;
+	}
+
+	LOG(LogDebug) << "ScanCache " << mSystemName << " : " << mHits << " directories from cache, " << mMisses << " enumerated";
+
+	if (!mDirty)
+		return true;
+
+	std::string out;
+	out.append(SCAN_CACHE_MAGIC, 4);
+	write<uint32_t>(out, SCAN_CACHE_VERSION);
+	write<uint32_t>(out, (uint32_t) mDirectories.size());
+
+	for (auto it = mDirectories.cbegin(); it != mDirectories.cend(); ++it)
+	{
+		writeString(out, it->first);
+		write<int64_t>(out, it->second.mtime);
+		write<uint32_t>(out, (uint32_t) it->second.entries.size());
+
+		for (auto entry = it->second.entries.cbegin(); entry != it->second.entries.cend(); ++entry)
+		{
+			writeString(out, entry->name);
+			write<unsigned char>(out, entry->flags);
+		}
+	}
+
+	std::string path = getCachePath(mSystemName);
+	std::string directory = Utils::FileSystem::getParent(path);
+	if (!Utils::FileSystem::exists(directory))
+		Utils::FileSystem::createDirectory(directory);
+
+	// write to a temporary file first so a crash never leaves a half written cache behind
+	std::string tmpPath = path + ".tmp";
+
+	std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG(LogError) << "Unable to write scan cache : " << tmpPath;
+		return false;
+	}
+
+	file.write(out.data(), out.size());
+	file.close();
+
+	if (file.fail())
+	{
+		LOG(LogError) << "Error writing scan cache : " << tmpPath;
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	Utils::FileSystem::removeFile(path);
+	if (rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "Unable to rename scan cache : " << tmpPath;
+		return false;
+	}
+
+	mDirty = false;
+	return true;
+}
+
+Utils::FileSystem::fileList ScanCache::getDirInfo(const std::string& _path)
+{
+	std::string path = Utils::FileSystem::getGenericPath(_path);
+
+	// read the time before enumerating : a change made during the enumeration is seen at the next start
+	long long mtime = Utils::FileSystem::getModificationTime(path);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mDirectories.find(path);
+	if (it != mDirectories.end() && mtime != 0 && it->second.mtime == mtime)
+	{
+		mHits++;
+		it->second.visited = true;
+
+		Utils::FileSystem::fileList ret;
+		for (auto entry = it->second.entries.cbegin(); entry != it->second.entries.cend(); ++entry)
+		{
+			Utils::FileSystem::FileInfo fi;
+			fi.path = path + "/" + entry->name;
+			fi.hidden = (entry->flags & FLAG_HIDDEN) != 0;
+			fi.directory = (entry->flags & FLAG_DIRECTORY) != 0;
+			fi.symlink = (entry->flags & FLAG_SYMLINK) != 0;
+			ret.push_back(fi);
+		}
+
+		return ret;
+	}
+
+	mMisses++;
+
+	// folders of a system may be scanned by several workers, don't hold the lock while enumerating
+	lock.unlock();
+
+	long long scanTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	Utils::FileSystem::fileList ret = Utils::FileSystem::getDirInfo(path);
+	if (mtime == 0)
+		return ret;
+
+	if (mtime > scanTime - SCAN_CACHE_MTIME_GRANULARITY_NS)
+	{
+		lock.lock();
+
+		if (mDirectories.erase(path) > 0)
+			mDirty = true;
+
+		return ret;
+	}
+
+	std::vector<Entry> entries;
+	entries.reserve(ret.size());
+
+	for (auto fi = ret.cbegin(); fi != ret.cend(); ++fi)
+	{
+		Entry entry;
+		entry.name = Utils::FileSystem::getFileName(fi->path);
+		entry.flags = (fi->hidden ? FLAG_HIDDEN : 0) | (fi->directory ? FLAG_DIRECTORY : 0) | (fi->symlink ? FLAG_SYMLINK : 0);
+		entries.push_back(entry);
+	}
+
+	lock.lock();
+
+	Directory& dir = mDirectories[path];
+	dir.mtime = mtime;
+	dir.visited = true;
+	dir.entries = std::move(entries);
+
+	mDirty = true;
+	return ret;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_APP_SCAN_CACHE_H
+#define ES_APP_SCAN_CACHE_H
+
+#include "utils/FileSystemUtil.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Remembers the content of every directory of a system along with the directory modification time.
+// At the next start, directories whose modification time did not change are not enumerated again.
+class ScanCache
+{
+public:
+	ScanCache(const std::string& systemName);
+
+	bool load();
+	bool save();
+
+	// Same as Utils::FileSystem::getDirInfo, served from the cache when the directory did not change. Thread safe.
+	Utils::FileSystem::fileList getDirInfo(const std::string& _path);
+
+	static std::string getCachePath(const std::string& systemName);
+
+private:
+	enum EntryFlags : unsigned char
+	{
+		FLAG_HIDDEN = 1,
+		FLAG_DIRECTORY = 2,
+		FLAG_SYMLINK = 4
+	};
+
+	struct Entry
+	{
+		std::string name;
+		unsigned char flags;
+	};
+
+	struct Directory
+	{
+		long long mtime;
+		bool visited;
+		std::vector<Entry> entries;
+	};
+
+	std::string mSystemName;
+	std::mutex mLock;
+	std::unordered_map<std::string, Directory> mDirectories;
+	bool mDirty;
+	int mHits;
+	int mMisses;
+};
+
+#endif // ES_APP_SCAN_CACHE_H
@@ -6,13 +6,15 @@
 #include "FileSorts.h"
 #include "Gamelist.h"
 #include "Log.h"
+#include "PersistenceManager.h"
 #include "platform.h"
+#include "ScanCache.h"
 #include "Settings.h"
 #include "ThemeData.h"
 #include "views/UIModeController.h"
 #include <fstream>
 #include "utils/StringUtil.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 #include "GuiComponent.h"
 #include "Window.h"
 
@@ -20,47 +22,134 @@ using namespace Utils;
 
 std::vector<SystemData*> SystemData::sSystemVector;
 
+// Shared by the tasks scanning the folders of a system
+struct SystemData::ScanContext
+{
+	ScanContext(std::unordered_map<std::string, FileData*>& map) : fileMap(map), cache(nullptr), parallel(false) { }
+
+	std::unordered_map<std::string, FileData*>& fileMap;
+	std::mutex	fileMapLock;
+	ScanCache*	cache;
+	bool		parallel; // sub folders are scanned by other workers
+};
+
+static bool isThreadedLoading()
+{
+	return std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading");
+}
+
 SystemData::SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem) :
 	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
 {
 	mGameCount = -1;
+	mGameCountVersion = 0;
 	mSortId = Settings::getInstance()->getInt(getName() + ".sort"),
 
 	mGridSizeOverride = Vector2f(0, 0);
 	mViewModeChanged = false;
 	mFilterIndex = nullptr;// new FileFilterIndex();
+	mNodePool = new FileDataPool();
 
 	// if it's an actual system, initialize it, if not, just create the data structure
 	if (!CollectionSystem)
 	{
-		mRootFolder = new FolderData(mEnvData->mStartPath, this);
+		mRootFolder = new (this) FolderData(mEnvData->mStartPath, this);
 		mRootFolder->metadata.set("name", mFullName);
 
 		std::unordered_map<std::string, FileData*> fileMap;
+
+		// The stages that don't depend on the scan run on other workers meanwhile :
+		// the theme is loaded and the gamelist is read, it's merged with the scanned files once both are done
+		bool threaded = isThreadedLoading();
+		bool useGamelist = !Settings::getInstance()->getBool("IgnoreGamelist");
+
+		Future<void> themeLoaded;
+		Future<bool> gamelistRead;
+		GamelistFile gamelist;
+
+		if (threaded)
+		{
+			themeLoaded = TaskScheduler::getInstance()->async([this]
+			{
+				StopWatch watch("SystemData " + mName + " : theme");
+				loadTheme();
+			});
+
+			if (useGamelist)
+			{
+				gamelistRead = TaskScheduler::getInstance()->async([this, &gamelist]
+				{
+					StopWatch watch("SystemData " + mName + " : gamelist read");
+					return gamelist.load(this);
+				});
+			}
+		}
 		
 		if (!Settings::getInstance()->getBool("ParseGamelistOnly"))
-		{			
-			populateFolder(mRootFolder, fileMap);
+		{
+			StopWatch watch("SystemData " + mName + " : scan");
+
+			ScanContext context(fileMap);
+			context.parallel = threaded;
+
+			if (Settings::getInstance()->getBool("ScanCache"))
+			{
+				ScanCache cache(mName);
+
+				// a forced rescan ignores the previous content but still writes a fresh cache
+				if (!Settings::getInstance()->getBool("ForceRescan"))
+					cache.load();
+
+				context.cache = &cache;
+				populateFolder(mRootFolder, context);
+				cache.save();
+			}
+			else
+				populateFolder(mRootFolder, context);
+
 			if (mRootFolder->getChildren().size() == 0)
+			{
+				// the tasks reference this system and the gamelist
+				if (themeLoaded.valid())
+					themeLoaded.wait();
+
+				if (gamelistRead.valid())
+					gamelistRead.wait();
+
 				return;
+			}
 		}
 
-		if (!Settings::getInstance()->getBool("IgnoreGamelist"))
-			parseGamelist(this, fileMap);
-			
-		refactorGameFolders(this);
+		if (useGamelist)
+		{
+			bool loaded = gamelistRead.valid() ? gamelistRead.get() : gamelist.load(this);
+			if (loaded)
+			{
+				StopWatch watch("SystemData " + mName + " : gamelist merge");
+				gamelist.apply(this, fileMap);
+			}
+		}
 
-		if (mSortId >= 0 && mSortId < FileSorts::SortTypes.size())
-			mRootFolder->sort(FileSorts::SortTypes.at(mSortId));
-		else
-			mRootFolder->sort(FileSorts::SortTypes.at(0));
+		{
+			StopWatch watch("SystemData " + mName + " : sort");
+
+			refactorGameFolders(this);
+
+			if (mSortId >= 0 && mSortId < FileSorts::SortTypes.size())
+				mRootFolder->sort(FileSorts::SortTypes.at(mSortId));
+			else
+				mRootFolder->sort(FileSorts::SortTypes.at(0));
+		}
 
 		//indexAllGameFilters(mRootFolder);
+
+		if (themeLoaded.valid())
+			themeLoaded.wait();
 	}
 	else
 	{
 		// virtual systems are updated afterwards, we're just creating the data structure
-		mRootFolder = new FolderData("" + name, this);
+		mRootFolder = new (this) FolderData("" + name, this);
 	}
 	
 	auto defaultView = Settings::getInstance()->getString(getName() + ".defaultView");
@@ -68,7 +157,9 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 	setSystemViewMode(defaultView, gridSizeOverride, false);
 
 	setIsGameSystemStatus();
-	loadTheme();
+
+	if (mTheme == nullptr)
+		loadTheme();
 }
 
 bool SystemData::setSystemViewMode(std::string newViewMode, Vector2f gridSizeOverride, bool setChanged)
@@ -103,6 +194,8 @@ SystemData::~SystemData()
 
 	if (mFilterIndex != nullptr)
 		delete mFilterIndex;
+
+	mNodePool->release();
 }
 
 void SystemData::setIsGameSystemStatus()
@@ -113,37 +206,35 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mName != "retropie");
 }
 
-void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+void SystemData::populateFolder(FolderData* folder, ScanContext& context)
 {
-	const std::string& folderPath = folder->getPath();
-	if(!Utils::FileSystem::isDirectory(folderPath))
-	{
-		LOG(LogWarning) << "Error - folder with path \"" << folderPath << "\" is not a directory!";
-		return;
-	}
+	const std::string folderPath = folder->getPath();
 
-	//make sure that this isn't a symlink to a thing we already have
-	if(Utils::FileSystem::isSymlink(folderPath))
+	// sub folders are checked from their directory entry before recursing
+	if (folder == mRootFolder)
 	{
-		//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
-		if(folderPath.find(Utils::FileSystem::getCanonicalPath(folderPath)) == 0)
+		if(!Utils::FileSystem::isDirectory(folderPath))
 		{
-			LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << folderPath << "\"";
+			LOG(LogWarning) << "Error - folder with path \"" << folderPath << "\" is not a directory!";
 			return;
 		}
+
+		if(Utils::FileSystem::isSymlink(folderPath) && isRecursiveSymlink(folderPath))
+			return;
 	}
 	
-//	std::string filePath;
 	std::string extension;
 	bool isGame;
 	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
 	
-	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirInfo(folderPath);
+	Utils::FileSystem::fileList dirContent = context.cache != nullptr ? context.cache->getDirInfo(folderPath) : Utils::FileSystem::getDirInfo(folderPath);
+
+	std::vector<FolderData*> subFolders;
+	TaskGroup subFolderTasks;
 
 	for(Utils::FileSystem::fileList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
 	{
 		auto fileInfo = *it;
-		//filePath = *it;
 
 		// skip hidden files and folders
 		if(!showHidden && fileInfo.hidden)
@@ -157,20 +248,25 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
 		
 		isGame = false;
-		if (mEnvData->isValidExtension(extension)) //std::find(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend(), extension) != mEnvData->mSearchExtensions.cend())
+		if (mEnvData->isValidExtension(extension))
 		{
-			if (fileMap.find(fileInfo.path) == fileMap.end())
-			{
-				FileData* newGame = new FileData(GAME, fileInfo.path, this);
+			FileData* newGame = new (this) FileData(GAME, fileInfo.path, this);
 
-				// preventing new arcade assets to be added
-				if (extension != ".zip" || !newGame->isArcadeAsset())
+			// preventing new arcade assets to be added
+			if (extension != ".zip" || !newGame->isArcadeAsset())
+			{
+				std::unique_lock<std::mutex> lock(context.fileMapLock);
+				if (context.fileMap.find(fileInfo.path) == context.fileMap.end())
 				{
-					folder->addChild(newGame);
-					fileMap[fileInfo.path] = newGame;
+					context.fileMap[fileInfo.path] = newGame;
 					isGame = true;
 				}
 			}
+
+			if (isGame)
+				folder->addChild(newGame);
+			else
+				delete newGame;
 		}
 		
 		//add directories that also do not match an extension as folders
@@ -179,24 +275,62 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (fileInfo.path.rfind("downloaded_") != std::string::npos || fileInfo.path.rfind("media") != std::string::npos)
 				continue;
 
-			FolderData* newFolder = new FolderData(fileInfo.path, this);
-			populateFolder(newFolder, fileMap);
+			//make sure that this isn't a symlink to a thing we already have
+			if (fileInfo.symlink && isRecursiveSymlink(fileInfo.path))
+				continue;
+
+			FolderData* newFolder = new (this) FolderData(fileInfo.path, this);
+			subFolders.push_back(newFolder);
 
-			if (newFolder->getChildren().size() == 0)
-				delete newFolder;
+			// a big tree is split across workers, each sub folder being scanned by its own task
+			if (context.parallel)
+				subFolderTasks.run([this, newFolder, &context] { populateFolder(newFolder, context); });
 			else
-			{
-				const std::string& key = newFolder->getPath();
-				if (fileMap.find(key) == fileMap.end())
-				{
-					folder->addChild(newFolder);
-					fileMap[key] = newFolder;
-				}
-			}
+				populateFolder(newFolder, context);
+		}
+	}
+
+	subFolderTasks.wait();
+
+	// only this task adds children to this folder, the sub folders are attached once they are complete
+	for (auto newFolder : subFolders)
+	{
+		if (newFolder->getChildren().size() == 0)
+		{
+			delete newFolder;
+			continue;
+		}
+
+		const std::string key = newFolder->getPath();
+
+		std::unique_lock<std::mutex> lock(context.fileMapLock);
+		if (context.fileMap.find(key) == context.fileMap.end())
+		{
+			context.fileMap[key] = newFolder;
+			lock.unlock();
+
+			folder->addChild(newFolder);
+		}
+		else
+		{
+			lock.unlock();
+			delete newFolder;
 		}
 	}
 }
 
+bool SystemData::isRecursiveSymlink(const std::string& path)
+{
+	//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
+	if(path.find(Utils::FileSystem::getCanonicalPath(path)) == 0)
+	{
+		LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << path << "\"";
+		return true;
+	}
+
+	return false;
+}
+
 FileFilterIndex* SystemData::getIndex(bool createIndex) 
 { 
 	if (mFilterIndex == nullptr && createIndex)
@@ -204,6 +338,8 @@ FileFilterIndex* SystemData::getIndex(bool createIndex)
 		mFilterIndex = new FileFilterIndex();
 		indexAllGameFilters(mRootFolder);
 		mFilterIndex->setUIModeFilters();
+
+		FolderData::invalidateDisplayedLists();
 	}
 
 	return mFilterIndex; 
@@ -411,27 +547,28 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pTasks = NULL;
 	SystemDataPtr* systems = NULL;
 	
-	if (std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading"))
+	if (isThreadedLoading())
 	{
-		pThreadPool = new ThreadPool();
+		pTasks = new TaskGroup();
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
 
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
+		pTasks->run([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
 	}
 
-	int processedSystem = 0;
+	// incremented by the workers, read by the loading screen
+	std::atomic<int> processedSystem(0);
 	
 	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{		
-		if (pThreadPool != NULL)
+		if (pTasks != NULL)
 		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
+			pTasks->run([system, currentSystem, systems, &processedSystem]
 			{				
 				systems[currentSystem] = loadSystem(system);
 				processedSystem++;
@@ -455,19 +592,20 @@ bool SystemData::loadConfig(Window* window)
 		currentSystem++;
 	}
 
-	if (pThreadPool != NULL)
+	if (pTasks != NULL)
 	{
 		if (window != NULL)
 		{
-			pThreadPool->wait([window, &processedSystem, systemCount, &systemsNames]
+			// the main thread only refreshes the loading screen, it sleeps until a worker is done or the delay expires
+			while (!pTasks->waitFor(10))
 			{
-				int px = processedSystem - 1;
+				int px = processedSystem.load() - 1;
 				if (px >= 0 && px < systemsNames.size())
 					window->renderLoadingScreen(systemsNames.at(px), (float)px / (float)(systemCount + 1));
-			}, 10);
+			}
 		}
 		else
-			pThreadPool->wait();
+			pTasks->wait();
 
 		for (int i = 0; i < systemCount; i++)
 		{
@@ -477,7 +615,7 @@ bool SystemData::loadConfig(Window* window)
 		}
 		
 		delete[] systems;
-		delete pThreadPool;
+		delete pTasks;
 
 		if (window != NULL)
 			window->renderLoadingScreen(_("Favorites"), systemCount == 0 ? 0 : currentSystem / systemCount);
@@ -548,15 +686,16 @@ void SystemData::deleteSystems()
 {
 	bool saveOnExit = !Settings::getInstance()->getBool("IgnoreGamelist") && Settings::getInstance()->getBool("SaveGamelistsOnExit");
 
-	for(unsigned int i = 0; i < sSystemVector.size(); i++)
-	{
-		SystemData* pData = sSystemVector.at(i);
+	if (saveOnExit)
+		for (auto system : sSystemVector)
+			if (!system->mIsCollectionSystem)
+				updateGamelist(system);
 
-		if (saveOnExit && !pData->mIsCollectionSystem)
-			updateGamelist(pData);
+	// pending saves capture the systems, write them before they are gone
+	PersistenceManager::getInstance()->flush();
 
-		delete pData;
-	}
+	for(unsigned int i = 0; i < sSystemVector.size(); i++)
+		delete sSystemVector.at(i);
 
 	sSystemVector.clear();
 }
@@ -657,7 +796,7 @@ bool SystemData::hasGamelist() const
 
 unsigned int SystemData::getGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME).size();
+	return (unsigned int)mRootFolder->getGameCount();
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -693,20 +832,43 @@ SystemData* SystemData::getRandomSystem()
 
 FileData* SystemData::getRandomGame()
 {
-	std::vector<FileData*> list = mRootFolder->getFilesRecursive(GAME, true);
-	unsigned int total = (int)list.size();
+	unsigned int total = (unsigned int)getDisplayedGameCount();
 	int target = 0;
 	// get random number in range
 	if (total == 0)
 		return NULL;
 	target = (int)Math::round((std::rand() / (float)RAND_MAX) * (total - 1));
-	return list.at(target);
+
+	// walk to it instead of listing every game
+	FileData* game = NULL;
+	mRootFolder->forEachFile(GAME, true, [&game, &target](FileData* file)
+	{
+		if (target-- > 0)
+			return true;
+
+		game = file;
+		return false;
+	});
+
+	return game;
 }
 
 int SystemData::getDisplayedGameCount() 
 {
-	if (mGameCount < 0)
-		mGameCount = mRootFolder->getFilesRecursive(GAME, true).size();
+	// Without filters, every game is displayed
+	FileFilterIndex* idx = getIndex(false);
+	if (idx == nullptr || !idx->isFiltered())
+		return mRootFolder->getGameCount();
+
+	unsigned long long version = mRootFolder->getDisplayVersion();
+	if (mGameCount < 0 || mGameCountVersion != version)
+	{
+		int count = 0;
+		mRootFolder->forEachFile(GAME, true, [&count](FileData*) { count++; return true; });
+
+		mGameCount = count;
+		mGameCountVersion = version;
+	}
 
 	return mGameCount;
 }
@@ -755,5 +917,7 @@ void SystemData::deleteIndex()
 	{
 		delete mFilterIndex;
 		mFilterIndex = nullptr;
+
+		FolderData::invalidateDisplayedLists();
 	}
 }
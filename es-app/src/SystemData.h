@@ -16,7 +16,9 @@
 #include "Settings.h"
 
 class FileData;
+class FileDataPool;
 class FolderData;
+class ScanCache;
 class ThemeData;
 class Window;
 
@@ -104,6 +106,7 @@ public:
 	~SystemData();
 
 	inline FolderData* getRootFolder() const { return mRootFolder; };
+	inline FileDataPool* getNodePool() const { return mNodePool; }
 	inline const std::string& getName() const { return mName; }
 	inline const std::string& getFullName() const { return mFullName; }
 	inline const std::string& getStartPath() const { return mEnvData->mStartPath; }
@@ -195,14 +198,20 @@ private:
 
 	unsigned int mSortId;
 
-	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	struct ScanContext;
+	void populateFolder(FolderData* folder, ScanContext& context);
+	static bool isRecursiveSymlink(const std::string& path);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 
 	FileFilterIndex* mFilterIndex;
 
 	FolderData* mRootFolder;
-	int			mGameCount;
+	FileDataPool* mNodePool; // released after the tree is deleted
+
+	// Displayed games when filtered, computed again when the display version changes
+	int					mGameCount;
+	unsigned long long	mGameCountVersion;
 };
 
 #endif // ES_APP_SYSTEM_DATA_H
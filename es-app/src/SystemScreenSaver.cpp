@@ -250,17 +250,16 @@ unsigned long SystemScreenSaver::countGameListNodes(const char *nodeName)
 
 		FolderData* rootFileData = (*it)->getRootFolder();
 
-		FileType type = GAME;
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(type, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
-
-		for(itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) {
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
+		rootFileData->forEachFile(GAME, true, [nodeName, &nodeCount](FileData* file)
+		{
+			if ((strcmp(nodeName, "video") == 0 && file->getVideoPath() != "") ||
+				(strcmp(nodeName, "image") == 0 && file->getImagePath() != ""))
 			{
 				nodeCount++;
 			}
-		}
+
+			return true;
+		});
 	}
 	return nodeCount;
 }
@@ -294,33 +293,39 @@ void SystemScreenSaver::pickGameListNode(unsigned long index, const char *nodeNa
 
 		FolderData* rootFileData = (*it)->getRootFolder();
 
-		FileType type = GAME;
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(type, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
-
-		for(itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) {
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
+		FileData* game = NULL;
+		rootFileData->forEachFile(GAME, true, [nodeName, &index, &game](FileData* file)
+		{
+			if ((strcmp(nodeName, "video") == 0 && file->getVideoPath() != "") ||
+				(strcmp(nodeName, "image") == 0 && file->getImagePath() != ""))
 			{
 				if (index-- == 0)
 				{
-					// We have it
-					path = "";
-					if (strcmp(nodeName, "video") == 0)
-						path = (*itf)->getVideoPath();
-					else if (strcmp(nodeName, "image") == 0)
-						path = (*itf)->getImagePath();
-					mSystemName = (*it)->getFullName();
-					mGameName = (*itf)->getName();
-					mCurrentGame = (*itf);
-
-					// end of getting FileData
-					if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never")
-						writeSubtitle(mGameName.c_str(), mSystemName.c_str(),
-							(Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
-					return;
+					game = file;
+					return false;
 				}
 			}
+
+			return true;
+		});
+
+		if (game != NULL)
+		{
+			// We have it
+			path = "";
+			if (strcmp(nodeName, "video") == 0)
+				path = game->getVideoPath();
+			else if (strcmp(nodeName, "image") == 0)
+				path = game->getImagePath();
+			mSystemName = (*it)->getFullName();
+			mGameName = game->getName();
+			mCurrentGame = game;
+
+			// end of getting FileData
+			if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never")
+				writeSubtitle(mGameName.c_str(), mSystemName.c_str(),
+					(Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
+			return;
 		}
 	}
 }
@@ -393,6 +393,10 @@ void ScraperSearchComponent::update(int deltaTime)
 		mBusyAnim.update(deltaTime);
 	}
 
+	// keep polling the pending requests
+	if(mBlockAccept || mThumbnailReq || mSearchHandle || mMDResolveHandle)
+		Window::invalidate();
+
 	if(mThumbnailReq && mThumbnailReq->status() != HttpReq::REQ_IN_PROGRESS)
 	{
 		updateThumbnail();
@@ -8,6 +8,7 @@
 #include "Log.h"
 #include "Sound.h"
 #include "Settings.h"
+#include "Window.h"
 #include <memory>
 
 class TextCache;
@@ -336,6 +337,8 @@ void TextListComponent<T>::update(int deltaTime)
 			while(mMarqueeTime > maxTime)
 				mMarqueeTime -= maxTime;
 
+			Window::invalidate();
+
 			mMarqueeOffset = (int)(Math::Scroll::loop(delay, scrollTime + returnTime, (float)mMarqueeTime, scrollLength + returnLength));
 
 			if(mMarqueeOffset > (scrollLength - (limit - returnLength)))
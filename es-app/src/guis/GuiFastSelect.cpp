@@ -3,6 +3,7 @@
 #include "views/gamelist/IGameListView.h"
 #include "FileSorts.h"
 #include "SystemData.h"
+#include "Window.h"
 
 static const std::string LETTERS = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
@@ -105,6 +106,7 @@ void GuiFastSelect::update(int deltaTime)
 		{
 			scroll();
 			mScrollAccumulator -= 150;
+			Window::invalidate();
 		}
 	}
 
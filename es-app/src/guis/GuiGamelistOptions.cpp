@@ -373,7 +373,23 @@ void GuiGamelistOptions::addTextFilterToMenu()
 
 	row.makeAcceptInputHandler([this, updateVal]
 	{
-		mWindow->pushGui(new GuiTextEditPopupKeyboard(mWindow, _("FILTER GAMES BY TEXT"), mTextFilter->getValue(), updateVal, false));
+		auto keyboard = new GuiTextEditPopupKeyboard(mWindow, _("FILTER GAMES BY TEXT"), mTextFilter->getValue(), updateVal, false);
+
+		// Number of games found while typing, the name index narrows the previous results at each letter
+		keyboard->setTextChangedCallback([this](const std::string& text) -> std::string
+		{
+			auto index = mSystem->getIndex(!text.empty());
+			if (index == nullptr || text.empty())
+				return "";
+
+			int count = index->countTextMatches(text);
+
+			char strbuf[256];
+			snprintf(strbuf, 256, EsLocale::nGetText("%i GAME", "%i GAMES", count).c_str(), count);
+			return strbuf;
+		});
+
+		mWindow->pushGui(keyboard);
 	});
 
 	mMenu.addRow(row);
@@ -1129,6 +1129,21 @@ void GuiMenu::openOtherSettings()
 	parse_gamelists->setState(Settings::getInstance()->getBool("ParseGamelistOnly"));
 	s->addWithLabel(_("PARSE GAMESLISTS ONLY"), parse_gamelists);
 	s->addSaveFunc([parse_gamelists] { Settings::getInstance()->setBool("ParseGamelistOnly", parse_gamelists->getState()); });
+
+	auto scan_cache = std::make_shared<SwitchComponent>(mWindow);
+	scan_cache->setState(Settings::getInstance()->getBool("ScanCache"));
+	s->addWithLabel(_("USE ROM SCAN CACHE"), scan_cache);
+	s->addSaveFunc([scan_cache] { Settings::getInstance()->setBool("ScanCache", scan_cache->getState()); });
+
+	auto gamelist_snapshot = std::make_shared<SwitchComponent>(mWindow);
+	gamelist_snapshot->setState(Settings::getInstance()->getBool("GamelistSnapshot"));
+	s->addWithLabel(_("USE GAMELIST SNAPSHOTS"), gamelist_snapshot);
+	s->addSaveFunc([gamelist_snapshot] { Settings::getInstance()->setBool("GamelistSnapshot", gamelist_snapshot->getState()); });
+
+	auto thumbnail_cache = std::make_shared<SwitchComponent>(mWindow);
+	thumbnail_cache->setState(Settings::getInstance()->getBool("ThumbnailCache"));
+	s->addWithLabel(_("USE THUMBNAIL CACHE"), thumbnail_cache);
+	s->addSaveFunc([thumbnail_cache] { Settings::getInstance()->setBool("ThumbnailCache", thumbnail_cache->getState()); });
 	
 #ifndef WIN32
 	auto local_art = std::make_shared<SwitchComponent>(mWindow);
@@ -1191,6 +1206,12 @@ void GuiMenu::openOtherSettings()
 	s->addWithLabel(_("SHOW FRAMERATE"), framerate);
 	s->addSaveFunc([framerate] { Settings::getInstance()->setBool("DrawFramerate", framerate->getState()); });
 
+	// profiler
+	auto profiler = std::make_shared<SwitchComponent>(mWindow);
+	profiler->setState(Settings::getInstance()->getBool("Profiler"));
+	s->addWithLabel(_("SHOW PROFILER"), profiler);
+	s->addSaveFunc([profiler] { Settings::getInstance()->setBool("Profiler", profiler->getState()); });
+
 	// threaded loading
 	auto threadedLoading = std::make_shared<SwitchComponent>(mWindow);
 	threadedLoading->setState(Settings::getInstance()->getBool("ThreadedLoading"));
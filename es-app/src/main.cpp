@@ -4,14 +4,17 @@
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/StringPool.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
 #include "InputManager.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "PersistenceManager.h"
 #include "platform.h"
 #include "PowerSaver.h"
+#include "Profiler.h"
 #include "ScraperCmdLine.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -127,6 +130,10 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("IgnoreGamelist", true);
 		}
+		else if (strcmp(argv[i], "--force-rescan") == 0)
+		{
+			Settings::getInstance()->setBool("ForceRescan", true);
+		}
 		else if (strcmp(argv[i], "--show-hidden-files") == 0)
 		{
 			Settings::getInstance()->setBool("ShowHiddenFiles", true);
@@ -135,6 +142,10 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("DrawFramerate", true);
 		}
+		else if (strcmp(argv[i], "--profile") == 0)
+		{
+			Settings::getInstance()->setBool("Profiler", true);
+		}
 		else if (strcmp(argv[i], "--no-exit") == 0)
 		{
 			Settings::getInstance()->setBool("ShowExit", false);
@@ -220,7 +231,9 @@ bool parseArgs(int argc, char* argv[])
 				"--resolution [width] [height]	try and force a particular resolution\n"
 				"--gamelist-only			skip automatic game search, only read from gamelist.xml\n"
 				"--ignore-gamelist		ignore the gamelist (useful for troubleshooting)\n"
+				"--force-rescan			ignore the rom scan cache and search all rom folders again\n"
 				"--draw-framerate		display the framerate\n"
+				"--profile			display the frame profiler, Ctrl-J writes a Chrome trace\n"
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
 				"--debug				more logging, show console on Windows\n"
@@ -286,6 +299,9 @@ bool loadSystemConfigFile(Window* window, const char** errorString)
 		return false;
 	}
 
+	// Metadata strings shared across the loaded gamelists
+	LOG(LogInfo) << Utils::StringPool::getInstance()->getReport();
+
 	return true;
 }
 
@@ -480,7 +496,10 @@ int main(int argc, char* argv[])
 		SDL_Event event;
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
 
-		if (ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		// nothing changed on screen since the last frame : sleep until an event, an invalidation or the next timed update
+		bool idle = !ps_standby && !window.isDirty();
+
+		if (ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : idle ? SDL_WaitEventTimeout(&event, window.getIdleTimeout()) : SDL_PollEvent(&event))
 		{
 			do
 			{
@@ -506,6 +525,9 @@ int main(int argc, char* argv[])
 			ps_time = SDL_GetTicks();			
 		}
 
+		// write the settings and gamelists that stopped changing
+		PersistenceManager::getInstance()->update();
+
 		if (window.isSleeping())
 		{
 			lastTime = SDL_GetTicks();
@@ -523,7 +545,17 @@ int main(int argc, char* argv[])
 
 		processAudioTitles(&window);
 
+		Profiler::beginFrame();
+
 		window.update(deltaTime);
+
+		if (!window.isDirty())
+		{
+			Profiler::endFrame();
+			Log::flush();
+			continue;
+		}
+
 		window.render();
 		
 		Log::flush();
@@ -542,6 +574,7 @@ int main(int argc, char* argv[])
 #endif
 
 		Renderer::swapBuffers();				
+		Profiler::endFrame();
 /*
 #ifdef WIN32	
 		int swapDuration = SDL_GetTicks() - swapStart;
@@ -561,6 +594,7 @@ int main(int argc, char* argv[])
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
+	PersistenceManager::getInstance()->flush();
 
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
@@ -11,8 +11,10 @@
 #include "views/gamelist/VideoGameListView.h"
 #include "views/SystemView.h"
 #include "views/UIModeController.h"
+#include "resources/TextureAtlas.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
@@ -308,6 +310,8 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	if (!loadIfnull)
 		return nullptr;
 
+	PROFILE_SCOPE("ViewController::createGameListView");
+
 	system->setUIModeFilters();
 	system->updateDisplayedGameCount();
 
@@ -541,7 +545,10 @@ void ViewController::render(const Transform4x4f& parentTrans)
 		Vector3f guiEnd = it->second->getPosition() + Vector3f(it->second->getSize().x(), it->second->getSize().y(), 0);
 
 		if (guiEnd.x() >= viewStart.x() && guiEnd.y() >= viewStart.y() && guiStart.x() <= viewEnd.x() && guiStart.y() <= viewEnd.y())
+		{
+			ProfileScope scope(typeid(*it->second));
 			it->second->render(trans);
+		}
 	}
 
 
@@ -654,6 +661,9 @@ void ViewController::reloadAll(Window* window)
 {
 	ThemeData::setDefaultTheme(nullptr);
 
+	// Theme images are packed again as the new views are displayed
+	TextureAtlas::getInstance()->reset();
+
 	SystemData* system = nullptr;
 
 	if (mState.viewing == SYSTEM_SELECT)
@@ -4,6 +4,7 @@
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 
@@ -61,6 +62,8 @@ void BasicGameListView::onFileChanged(FileData* file, FileChangeType change)
 
 void BasicGameListView::populateList(const std::vector<FileData*>& files)
 {
+	PROFILE_SCOPE("GameListView::populateList");
+
 	mList.clear();
 
 	std::string systemName = mRoot->getSystem()->getFullName();
@@ -150,7 +153,7 @@ void BasicGameListView::setCursor(FileData* cursor)
 void BasicGameListView::addPlaceholder()
 {
 	// empty list - add a placeholder
-	FileData* placeholder = new FileData(PLACEHOLDER, "<No Entries Found>", this->mRoot->getSystem());
+	FileData* placeholder = new (this->mRoot->getSystem()) FileData(PLACEHOLDER, "<No Entries Found>", this->mRoot->getSystem());
 	mList.add(placeholder->getName(), placeholder, (placeholder->getType() == PLACEHOLDER));
 }
 
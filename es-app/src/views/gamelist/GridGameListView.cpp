@@ -4,6 +4,7 @@
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
@@ -201,6 +202,8 @@ const std::string GridGameListView::getImagePath(FileData* file)
 
 void GridGameListView::populateList(const std::vector<FileData*>& files)
 {
+	PROFILE_SCOPE("GameListView::populateList");
+
 	mGrid.clear();
 	mHeaderText.setText(mRoot->getSystem()->getFullName());
 
@@ -488,7 +491,7 @@ void GridGameListView::updateInfoPanel()
 void GridGameListView::addPlaceholder()
 {
 	// empty grid - add a placeholder
-	FileData* placeholder = new FileData(PLACEHOLDER, "<No Entries Found>", this->mRoot->getSystem());
+	FileData* placeholder = new (this->mRoot->getSystem()) FileData(PLACEHOLDER, "<No Entries Found>", this->mRoot->getSystem());
 	mGrid.add(placeholder->getName(), "", "", "", placeholder);
 }
 
@@ -5,6 +5,7 @@
 #include "animations/LambdaAnimation.h"
 #include "Log.h"
 #include "renderers/Renderer.h"
+#include "Profiler.h"
 #include "ThemeData.h"
 #include "Window.h"
 #include <algorithm>
@@ -53,7 +54,10 @@ void GuiComponent::updateChildren(int deltaTime)
 {
 	for(unsigned int i = 0; i < getChildCount(); i++)
 	{
-		getChild(i)->update(deltaTime);
+		GuiComponent* child = getChild(i);
+
+		ProfileScope scope(typeid(*child));
+		child->update(deltaTime);
 	}
 }
 
@@ -76,7 +80,10 @@ void GuiComponent::renderChildren(const Transform4x4f& transform) const
 {
 	for(unsigned int i = 0; i < getChildCount(); i++)
 	{
-		getChild(i)->render(transform);
+		GuiComponent* child = getChild(i);
+
+		ProfileScope scope(typeid(*child));
+		child->render(transform);
 	}
 }
 
@@ -390,6 +397,8 @@ bool GuiComponent::advanceAnimation(unsigned char slot, unsigned int time)
 			mAnimationMap[slot] = NULL;
 			delete anim;
 		}
+
+		Window::invalidate();
 		return true;
 	}else{
 		return false;
@@ -8,7 +8,49 @@
 #include <iostream>
 #include "math/Vector2i.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
 #include "utils/StringUtil.h"
+#include <algorithm>
+#include <cmath>
+
+// Reads the dimensions in the frame header of a JPEG file in memory
+static bool getJpegSizeFromMemory(const unsigned char* data, const size_t size, Vector2i& imageSize)
+{
+	if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+		return false;
+
+	size_t pos = 2;
+	while (pos + 9 < size)
+	{
+		if (data[pos] != 0xFF)
+			return false;
+
+		unsigned char marker = data[pos + 1];
+
+		// padding
+		if (marker == 0xFF)
+		{
+			pos++;
+			continue;
+		}
+
+		// SOFn, except DHT (C4), JPG (C8) and DAC (CC)
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+		{
+			int height = (data[pos + 5] << 8) + data[pos + 6];
+			int width = (data[pos + 7] << 8) + data[pos + 8];
+			if (width <= 0 || height <= 0)
+				return false;
+
+			imageSize = Vector2i(width, height);
+			return true;
+		}
+
+		pos += 2 + (data[pos + 2] << 8) + data[pos + 3];
+	}
+
+	return false;
+}
 
 bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 {
@@ -138,33 +180,14 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 
 					//loop through scanlines and add all pixel data to the return vector
 					//this is necessary, because width*height*bpp might not be == pitch
+					rawData.resize(width * height * 4);
 
-					unsigned char * tempData = new unsigned char[width * height * 4];
-					unsigned char * bytes = FreeImage_GetBits(fiBitmap);
-
-				//	memcpy(tempData, bytes, width * height * 4);
-/*
-					for (size_t i = 0; i < height; i++)
-					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
-					}*/
 					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
-					{
-						RGBQUAD bgra = ((RGBQUAD *)bytes)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
-					}
-					
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
+					for (size_t i = 0; i < height; i++)
+						Utils::Pixel::swapRedBlue(FreeImage_GetScanLine(fiBitmap, (int)i), rawData.data() + (i * width * 4), width);
+
 					//free bitmap data
 					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
 				}
 			}
 			else
@@ -252,8 +275,26 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
 		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
 		{
+			// JPEG can be decoded at 1/2, 1/4 or 1/8 of its size by the codec. The upper 16 bits of the flags ask FreeImage
+			// for the smallest of these scales still at least as big as the requested size, the box filter below does the rest.
+			int flags = 0;
+			Vector2i sourceSize;
+
+			if (format == FIF_JPEG && maxWidth > 0 && maxHeight > 0 && getJpegSizeFromMemory(data, size, sourceSize) && (sourceSize.x() > maxWidth || sourceSize.y() > maxHeight))
+			{
+				Vector2i sz = adjustPictureSize(sourceSize, Vector2i(maxWidth, maxHeight), externZoom);
+				double scale = std::max((double)sz.x() / sourceSize.x(), (double)sz.y() / sourceSize.y());
+
+				if (scale > 0 && scale <= 0.5)
+				{
+					int requestedSize = (int)std::ceil(scale * std::max(sourceSize.x(), sourceSize.y()));
+					if (requestedSize > 0 && requestedSize < 0xFFFF)
+						flags = requestedSize << 16;
+				}
+			}
+
 			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
+			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory, flags);
 			if (fiBitmap != nullptr)
 			{
 				//loaded. convert to 32bit if necessary
@@ -274,11 +315,32 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 					height = FreeImage_GetHeight(fiBitmap);
 
 					baseSize = Vector2i(width, height);
+
+					// Decoded smaller than the source : the texture may have to be decoded again if it's displayed bigger
+					if (flags != 0 && (sourceSize.x() != width || sourceSize.y() != height))
+					{
+						baseSize = sourceSize;
+						packedSize = Vector2i(width, height);
+					}
+
+					unsigned char* tempData = nullptr;
 					
 					if (maxWidth > 0 && maxHeight > 0 && (width > maxWidth || height > maxHeight))
 					{
 						Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxWidth, maxHeight), externZoom);
-						if (sz.x() != width || sz.y() != height)
+						if (sz.x() > 0 && sz.y() > 0 && sz.x() <= width && sz.y() <= height && (sz.x() != width || sz.y() != height))
+						{
+							// Box filter straight into the texture buffer, then swizzled in place
+							tempData = new unsigned char[sz.x() * sz.y() * 4];
+							Utils::Pixel::downscaleBox(FreeImage_GetBits(fiBitmap), width, height, FreeImage_GetPitch(fiBitmap), tempData, sz.x(), sz.y());
+							Utils::Pixel::swapRedBlue(tempData, tempData, sz.x() * sz.y());
+
+							width = sz.x();
+							height = sz.y();
+
+							packedSize = Vector2i(width, height);
+						}
+						else if (sz.x() != width || sz.y() != height)
 						{							
 							FIBITMAP* imageRescaled = FreeImage_Rescale(fiBitmap, sz.x(), sz.y(), FILTER_BOX);
 							FreeImage_Unload(fiBitmap);
@@ -291,22 +353,14 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 						}
 					}
 					
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-
-					unsigned char* tempData = new unsigned char[width * height * 4];
-
-					int w = (int)width;
-
-					for (int y = (int)height; --y >= 0; )
+					if (tempData == nullptr)
 					{
-						unsigned int* argb = (unsigned int*)FreeImage_GetScanLine(fiBitmap, y);
-						unsigned int* abgr = (unsigned int*)(tempData + (y * width * 4));
-						for (int x = w; --x >= 0;)
-						{
-							unsigned int c = argb[x];
-							abgr[x] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
-						}
+						//loop through scanlines and add all pixel data to the return vector
+						//this is necessary, because width*height*bpp might not be == pitch
+						tempData = new unsigned char[width * height * 4];
+
+						for (int y = 0; y < (int)height; y++)
+							Utils::Pixel::swapRedBlue(FreeImage_GetScanLine(fiBitmap, y), tempData + (y * width * 4), width);
 					}
 				
 					FreeImage_Unload(fiBitmap);
@@ -333,15 +387,5 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 
 void ImageIO::flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height)
 {
-	unsigned int temp;
-	unsigned int* arr = (unsigned int*)imagePx;
-	for(size_t y = 0; y < height / 2; y++)
-	{
-		for(size_t x = 0; x < width; x++)
-		{
-			temp = arr[x + (y * width)];
-			arr[x + (y * width)] = arr[x + (height * width) - ((y + 1) * width)];
-			arr[x + (height * width) - ((y + 1) * width)] = temp;
-		}
-	}
+	Utils::Pixel::flipVertical(imagePx, width, height);
 }
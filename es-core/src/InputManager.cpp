@@ -3,6 +3,7 @@
 #include "utils/FileSystemUtil.h"
 #include "CECInput.h"
 #include "Log.h"
+#include "PersistenceManager.h"
 #include "platform.h"
 #include "Scripting.h"
 #include "Window.h"
@@ -426,6 +427,7 @@ void InputManager::doOnFinish()
 
 						LOG(LogInfo) << "	" << tocall;
 						std::cout << "==============================================\ninput config finish command:\n";
+						PersistenceManager::getInstance()->flush();
 						int exitCode = runSystemCommand(tocall, "", NULL);
 						std::cout << "==============================================\n";
 
@@ -4,7 +4,6 @@
 #include "utils/FileSystemUtil.h"
 #include "Log.h"
 #include <pugixml/src/pugixml.hpp>
-#include <string.h>
 
 MameNames* MameNames::sInstance = nullptr;
 
@@ -54,8 +53,7 @@ MameNames::MameNames()
 
 	for(pugi::xml_node gameNode = doc.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
 	{
-		NamePair namePair = { gameNode.child("mamename").text().get(), gameNode.child("realname").text().get() };
-		mNamePairs.push_back(namePair);
+		mNamePairs[gameNode.child("mamename").text().get()] = gameNode.child("realname").text().get();
 	}
 
 	// Read bios
@@ -76,8 +74,7 @@ MameNames::MameNames()
 
 	for(pugi::xml_node biosNode = doc.child("bios"); biosNode; biosNode = biosNode.next_sibling("bios"))
 	{
-		std::string bios = biosNode.text().get();
-		mMameBioses.push_back(bios);
+		mMameBioses.insert(biosNode.text().get());
 	}
 
 	// Read devices
@@ -98,8 +95,7 @@ MameNames::MameNames()
 
 	for(pugi::xml_node deviceNode = doc.child("device"); deviceNode; deviceNode = deviceNode.next_sibling("device"))
 	{
-		std::string device = deviceNode.text().get();
-		mMameDevices.push_back(device);
+		mMameDevices.insert(deviceNode.text().get());
 	}
 
 } // MameNames
@@ -111,18 +107,9 @@ MameNames::~MameNames()
 
 std::string MameNames::getRealName(const std::string& _mameName)
 {
-	size_t start = 0;
-	size_t end   = mNamePairs.size();
-
-	while(start < end)
-	{
-		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(mNamePairs[index].mameName.c_str(), _mameName.c_str());
-
-		if(compare < 0)       start = index + 1;
-		else if( compare > 0) end   = index;
-		else                  return mNamePairs[index].realName;
-	}
+	auto it = mNamePairs.find(_mameName);
+	if(it != mNamePairs.cend())
+		return it->second;
 
 	return _mameName;
 
@@ -130,31 +117,12 @@ std::string MameNames::getRealName(const std::string& _mameName)
 
 const bool MameNames::isBios(const std::string& _biosName)
 {
-	return MameNames::find(mMameBioses, _biosName);
+	return mMameBioses.find(_biosName) != mMameBioses.cend();
 
 } // isBios
 
 const bool MameNames::isDevice(const std::string& _deviceName)
 {
-	return MameNames::find(mMameDevices, _deviceName);
+	return mMameDevices.find(_deviceName) != mMameDevices.cend();
 
 } // isDevice
-
-const bool MameNames::find(std::vector<std::string> devices, const std::string& name)
-{
-	size_t start = 0;
-	size_t end   = devices.size();
-
-	while(start < end)
-	{
-		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(devices[index].c_str(), name.c_str());
-
-		if(compare < 0)       start = index + 1;
-		else if( compare > 0) end   = index;
-		else                  return true;
-	}
-
-	return false;
-
-}
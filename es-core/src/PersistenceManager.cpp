@@ -0,0 +1,186 @@
+#include "PersistenceManager.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// Time without change before an entry is written
+#define QUIET_PERIOD_MS		2000
+// Upper bound when an entry keeps changing (ex: scraping), so it's still saved from time to time
+#define MAX_DELAY_MS		10000
+
+PersistenceManager* PersistenceManager::getInstance()
+{
+	static PersistenceManager* sInstance = new PersistenceManager();
+	return sInstance;
+}
+
+PersistenceManager::PersistenceManager() : mWriting(false)
+{
+}
+
+void PersistenceManager::markDirty(const std::string& key, CaptureFunction capture)
+{
+	std::unique_lock<std::mutex> lock(mPendingLock);
+
+	Clock::time_point now = Clock::now();
+
+	auto it = mPending.find(key);
+	if (it == mPending.end())
+	{
+		PendingEntry& entry = mPending[key];
+		entry.capture = capture;
+		entry.firstChange = now;
+		entry.lastChange = now;
+	}
+	else
+	{
+		it->second.capture = capture;
+		it->second.lastChange = now;
+	}
+}
+
+void PersistenceManager::update()
+{
+	std::vector<std::pair<std::string, PendingEntry>> ready;
+
+	{
+		std::unique_lock<std::mutex> lock(mPendingLock);
+		if (mPending.empty())
+			return;
+
+		Clock::time_point now = Clock::now();
+
+		for (auto it = mPending.begin(); it != mPending.end(); )
+		{
+			auto quiet = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.lastChange).count();
+			auto waiting = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.firstChange).count();
+
+			if (quiet >= QUIET_PERIOD_MS || waiting >= MAX_DELAY_MS)
+			{
+				ready.push_back(*it);
+				it = mPending.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	// captures may call markDirty, don't hold the lock
+	for (auto& entry : ready)
+		capture(entry.first, entry.second);
+}
+
+void PersistenceManager::flush()
+{
+	std::map<std::string, PendingEntry> pending;
+
+	{
+		std::unique_lock<std::mutex> lock(mPendingLock);
+		pending.swap(mPending);
+	}
+
+	for (auto& entry : pending)
+		capture(entry.first, entry.second);
+
+	mTasks.wait();
+}
+
+void PersistenceManager::capture(const std::string& key, PendingEntry& entry)
+{
+	WriteFunction write = entry.capture();
+	if (write == nullptr)
+		return;
+
+	std::unique_lock<std::mutex> lock(mJobsLock);
+
+	// a newer capture of the same key supersedes a job that didn't start yet
+	bool replaced = false;
+	for (auto& job : mJobs)
+	{
+		if (job.key == key)
+		{
+			job.write = write;
+			replaced = true;
+			break;
+		}
+	}
+
+	if (!replaced)
+	{
+		WriteJob job;
+		job.key = key;
+		job.write = write;
+		job.firstChange = entry.firstChange;
+		mJobs.push_back(job);
+	}
+
+	// one writer at a time, files are written in the order they were captured
+	if (!mWriting)
+	{
+		mWriting = true;
+		mTasks.run([this] { processJobs(); });
+	}
+}
+
+void PersistenceManager::processJobs()
+{
+	std::unique_lock<std::mutex> lock(mJobsLock);
+
+	while (!mJobs.empty())
+	{
+		WriteJob job = mJobs.front();
+		mJobs.pop_front();
+
+		lock.unlock();
+
+		Clock::time_point start = Clock::now();
+		size_t bytes = job.write();
+		Clock::time_point end = Clock::now();
+
+		LOG(LogInfo) << "PersistenceManager : " << job.key << " saved, " << bytes << " bytes written in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms, "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(end - job.firstChange).count() << " ms after the first change";
+
+		lock.lock();
+	}
+
+	mWriting = false;
+}
+
+bool PersistenceManager::writeFile(const std::string& path, const std::string& data)
+{
+	std::string tmpPath = path + ".tmp";
+
+	std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG(LogError) << "Unable to write \"" << tmpPath << "\"";
+		return false;
+	}
+
+	file.write(data.data(), data.size());
+	file.close();
+
+	if (file.fail())
+	{
+		LOG(LogError) << "Error writing \"" << tmpPath << "\"";
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+#if defined(_WIN32)
+	// rename can't replace an existing file on Windows
+	Utils::FileSystem::removeFile(path);
+#endif
+
+	if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "Unable to rename \"" << tmpPath << "\" to \"" << path << "\"";
+		return false;
+	}
+
+	return true;
+}
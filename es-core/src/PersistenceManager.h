@@ -0,0 +1,69 @@
+#pragma once
+#ifndef ES_CORE_PERSISTENCE_MANAGER_H
+#define ES_CORE_PERSISTENCE_MANAGER_H
+
+#include "utils/TaskScheduler.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Saves files (settings, gamelists...) in the background, once the data stopped changing for a while.
+//
+// The data is captured on the main thread, from update() or flush(), so nothing is read while the UI modifies it.
+// The capture returns the function writing the file, which runs on a worker and returns the number of bytes written.
+class PersistenceManager
+{
+public:
+	typedef std::function<size_t(void)> WriteFunction;
+	typedef std::function<WriteFunction(void)> CaptureFunction;
+
+	static PersistenceManager* getInstance();
+
+	// (Re)starts the quiet period of key, the capture replaces the pending one of the same key
+	void markDirty(const std::string& key, CaptureFunction capture);
+
+	// Main thread, once per frame : captures the entries whose quiet period is over
+	void update();
+
+	// Captures every pending entry now and waits until everything is written.
+	// Must be called before destroying anything a pending capture refers to.
+	void flush();
+
+	// Writes through a temporary file renamed over path, a crash never leaves a truncated file
+	static bool writeFile(const std::string& path, const std::string& data);
+
+private:
+	PersistenceManager();
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct PendingEntry
+	{
+		CaptureFunction		capture;
+		Clock::time_point	firstChange;
+		Clock::time_point	lastChange;
+	};
+
+	struct WriteJob
+	{
+		std::string			key;
+		WriteFunction		write;
+		Clock::time_point	firstChange;
+	};
+
+	void capture(const std::string& key, PendingEntry& entry);
+	void processJobs();
+
+	std::map<std::string, PendingEntry>	mPending;
+	std::mutex							mPendingLock;
+
+	std::deque<WriteJob>				mJobs;
+	std::mutex							mJobsLock;
+	bool								mWriting;
+	Utils::TaskGroup					mTasks;
+};
+
+#endif // ES_CORE_PERSISTENCE_MANAGER_H
@@ -0,0 +1,348 @@
+#include "Profiler.h"
+
+#include "math/Transform4x4f.h"
+#include "renderers/Renderer.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/TimeUtil.h"
+#include "Log.h"
+#include "PersistenceManager.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdlib.h>
+#include <vector>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+// Frames kept in the ring buffer, about 2 seconds at 60 fps
+#define PROFILER_FRAME_COUNT	120
+// Scopes listed by the overlay
+#define PROFILER_TOP_COUNT		6
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+namespace
+{
+	struct ProfileEvent
+	{
+		const char*				name;
+		const std::type_info*	type;
+		int						thread;
+		long long				start;
+		long long				duration;
+		long long				self;
+	};
+
+	struct ProfileFrame
+	{
+		long long					start;
+		long long					end;
+		std::vector<ProfileEvent>	events;
+	};
+
+	std::mutex					sLock;
+	std::vector<ProfileFrame>	sFrames(PROFILER_FRAME_COUNT);
+	int							sCurrent = 0;	// frame being recorded
+	int							sCount = 0;		// finished frames in the ring
+	int							sMainThread = -1;
+
+	std::atomic<int>			sNextThread(0);
+	thread_local int			sThread = -1;
+
+	// Time spent in the nested scopes of each open scope of this thread
+	thread_local std::vector<long long> sChildTime;
+
+	const std::chrono::steady_clock::time_point sEpoch = std::chrono::steady_clock::now();
+
+	int getThreadIndex()
+	{
+		if (sThread < 0)
+			sThread = sNextThread++;
+
+		return sThread;
+	}
+
+	std::string getTypeName(const std::type_info* type)
+	{
+#ifdef __GNUC__
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+		if (status == 0 && demangled != nullptr)
+		{
+			std::string name(demangled);
+			free(demangled);
+			return name;
+		}
+#endif
+		// MSVC names are readable, without the "class " prefix
+		std::string name(type->name());
+		if (name.compare(0, 6, "class ") == 0)
+			return name.substr(6);
+		if (name.compare(0, 7, "struct ") == 0)
+			return name.substr(7);
+
+		return name;
+	}
+
+	std::string getEventName(const ProfileEvent& event)
+	{
+		if (event.name != nullptr)
+			return event.name;
+
+		// Demangling is slow, the same component classes come back in every frame
+		static std::map<const std::type_info*, std::string> names;
+
+		auto it = names.find(event.type);
+		if (it != names.cend())
+			return it->second;
+
+		std::string name = getTypeName(event.type);
+		names[event.type] = name;
+		return name;
+	}
+
+	std::string escapeJson(const std::string& value)
+	{
+		std::string ret;
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\')
+				ret += '\\';
+
+			ret += c;
+		}
+
+		return ret;
+	}
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	if (sEnabled == enabled)
+		return;
+
+	std::unique_lock<std::mutex> lock(sLock);
+
+	// Start over, the frames recorded before were not complete
+	for (auto& frame : sFrames)
+		frame.events.clear();
+
+	sCurrent = 0;
+	sCount = 0;
+	sFrames[0].start = getTime();
+
+	sEnabled = enabled;
+}
+
+long long Profiler::getTime()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sEpoch).count();
+}
+
+void Profiler::beginFrame()
+{
+	if (!isEnabled())
+		return;
+
+	std::unique_lock<std::mutex> lock(sLock);
+
+	sMainThread = getThreadIndex();
+	sFrames[sCurrent].start = getTime();
+}
+
+void Profiler::endFrame()
+{
+	if (!isEnabled())
+		return;
+
+	std::unique_lock<std::mutex> lock(sLock);
+
+	sFrames[sCurrent].end = getTime();
+
+	if (sCount < PROFILER_FRAME_COUNT)
+		sCount++;
+
+	// Reuse the oldest frame, its events keep their capacity
+	sCurrent = (sCurrent + 1) % PROFILER_FRAME_COUNT;
+	sFrames[sCurrent].events.clear();
+	sFrames[sCurrent].start = getTime();
+}
+
+void Profiler::addEvent(const char* name, const std::type_info* type, long long start, long long end, long long self)
+{
+	if (!isEnabled())
+		return;
+
+	ProfileEvent event;
+	event.name = name;
+	event.type = type;
+	event.thread = getThreadIndex();
+	event.start = start;
+	event.duration = end - start;
+	event.self = self;
+
+	std::unique_lock<std::mutex> lock(sLock);
+	sFrames[sCurrent].events.push_back(event);
+}
+
+long long ProfileScope::begin()
+{
+	sChildTime.push_back(0);
+	return Profiler::getTime();
+}
+
+void ProfileScope::end()
+{
+	long long end = Profiler::getTime();
+	long long duration = end - mStart;
+
+	long long childTime = sChildTime.back();
+	sChildTime.pop_back();
+
+	if (!sChildTime.empty())
+		sChildTime.back() += duration;
+
+	Profiler::addEvent(mName, mType, mStart, end, duration - childTime);
+}
+
+void Profiler::renderOverlay()
+{
+	if (!isEnabled())
+		return;
+
+	std::vector<long long> durations;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+
+		for (int i = sCount; i > 0; i--)
+		{
+			const ProfileFrame& frame = sFrames[(sCurrent - i + PROFILER_FRAME_COUNT) % PROFILER_FRAME_COUNT];
+			durations.push_back(frame.end - frame.start);
+		}
+	}
+
+	// One bar per frame along the bottom of the screen, the top of the graph is 2 frames at 60 fps
+	const float scale = Renderer::getScreenHeight() / 720.0f;
+	const float barWidth = 3.0f * scale;
+	const float graphHeight = 100.0f * scale;
+	const float left = 50.0f * scale;
+	const float bottom = Renderer::getScreenHeight() - 50.0f * scale;
+	const float frameBudget = 1000000.0f / 60.0f;
+
+	Renderer::setMatrix(Transform4x4f::Identity());
+	Renderer::drawRect(left, bottom - graphHeight, barWidth * PROFILER_FRAME_COUNT, graphHeight, 0x00000080);
+
+	for (size_t i = 0; i < durations.size(); i++)
+	{
+		float height = std::min(graphHeight, graphHeight * durations[i] / (frameBudget * 2));
+		unsigned int color = durations[i] <= frameBudget ? 0x00FF00C0 : durations[i] <= frameBudget * 2 ? 0xFFFF00C0 : 0xFF0000C0;
+
+		Renderer::drawRect(left + i * barWidth, bottom - height, barWidth - 1.0f, height, color);
+	}
+
+	// 60 fps line
+	Renderer::drawRect(left, bottom - graphHeight / 2, barWidth * PROFILER_FRAME_COUNT, 1.0f, 0xFFFFFF80);
+}
+
+std::string Profiler::getSummary()
+{
+	if (!isEnabled())
+		return "";
+
+	struct ScopeTotal
+	{
+		long long self;
+		long long max;
+	};
+
+	std::map<std::string, ScopeTotal> totals;
+	long long frameTotal = 0;
+	long long frameMax = 0;
+	int frames = 0;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+
+		for (int i = sCount; i > 0; i--)
+		{
+			const ProfileFrame& frame = sFrames[(sCurrent - i + PROFILER_FRAME_COUNT) % PROFILER_FRAME_COUNT];
+
+			frameTotal += frame.end - frame.start;
+			frameMax = std::max(frameMax, frame.end - frame.start);
+			frames++;
+
+			for (auto& event : frame.events)
+			{
+				bool background = event.thread != sMainThread;
+				std::string name = getEventName(event);
+
+				ScopeTotal& total = totals[background ? name + " (bg)" : name];
+				total.self += event.self;
+				total.max = std::max(total.max, event.self);
+			}
+		}
+	}
+
+	if (frames == 0)
+		return "";
+
+	std::vector<std::pair<std::string, ScopeTotal>> sorted(totals.cbegin(), totals.cend());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, ScopeTotal>& a, const std::pair<std::string, ScopeTotal>& b) { return a.second.self > b.second.self; });
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2);
+	ss << "Profiler: " << frames << " frames, avg " << (frameTotal / frames / 1000.0f) << "ms, max " << (frameMax / 1000.0f) << "ms";
+
+	for (size_t i = 0; i < sorted.size() && i < PROFILER_TOP_COUNT; i++)
+		ss << "\n" << sorted[i].first << ": " << (sorted[i].second.self / frames / 1000.0f) << "ms/frame, max " << (sorted[i].second.max / 1000.0f) << "ms";
+
+	return ss.str();
+}
+
+std::string Profiler::dump()
+{
+	std::stringstream ss;
+	ss << "{\"traceEvents\":[";
+
+	bool first = true;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+
+		for (int i = sCount; i > 0; i--)
+		{
+			const ProfileFrame& frame = sFrames[(sCurrent - i + PROFILER_FRAME_COUNT) % PROFILER_FRAME_COUNT];
+
+			ss << (first ? "" : ",") << "\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":" << sMainThread <<
+				",\"ts\":" << frame.start << ",\"dur\":" << (frame.end - frame.start) << "}";
+			first = false;
+
+			for (auto& event : frame.events)
+			{
+				ss << ",\n{\"name\":\"" << escapeJson(getEventName(event)) << "\",\"cat\":\"" << (event.name != nullptr ? "es" : "component") <<
+					"\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+			}
+		}
+	}
+
+	ss << "\n]}\n";
+
+	if (first)
+		return "";
+
+	std::string path = Utils::FileSystem::getHomePath() + "/.emulationstation/profile-" + Utils::Time::timeToString(Utils::Time::now()) + ".json";
+	if (!PersistenceManager::writeFile(path, ss.str()))
+	{
+		LOG(LogError) << "Profiler : unable to write " << path;
+		return "";
+	}
+
+	LOG(LogInfo) << "Profiler : trace written to " << path;
+	return path;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef ES_CORE_PROFILER_H
+#define ES_CORE_PROFILER_H
+
+#include <atomic>
+#include <string>
+#include <typeinfo>
+
+// Built-in frame profiler, enabled with the "Profiler" setting (--profile, Ctrl-P).
+//
+// Scopes are timed on any thread and stored with the frame they end in. The last frames are kept in a ring
+// buffer : the overlay draws their durations with the most expensive scopes, and dump() writes them as a
+// Chrome trace (chrome://tracing, Perfetto). When disabled, a scope costs a single flag test.
+class Profiler
+{
+public:
+	static inline bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+	static void setEnabled(bool enabled);
+
+	// Called by the main loop around each frame
+	static void beginFrame();
+	static void endFrame();
+
+	static long long getTime(); // microseconds
+
+	static void renderOverlay();
+	static std::string getSummary();
+
+	// Writes the frames of the ring buffer as a Chrome trace, returns the file path or an empty string
+	static std::string dump();
+
+private:
+	friend class ProfileScope;
+
+	// self is the duration minus the nested scopes of the same thread
+	static void addEvent(const char* name, const std::type_info* type, long long start, long long end, long long self);
+
+	static std::atomic<bool> sEnabled;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name) : mName(name), mType(nullptr), mStart(Profiler::isEnabled() ? begin() : -1) { }
+	// Named after the class of a component, resolved only when the profile is displayed
+	ProfileScope(const std::type_info& type) : mName(nullptr), mType(&type), mStart(Profiler::isEnabled() ? begin() : -1) { }
+
+	~ProfileScope()
+	{
+		if (mStart >= 0)
+			end();
+	}
+
+private:
+	long long begin();
+	void end();
+
+	const char*				mName;
+	const std::type_info*	mType;
+	long long				mStart;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#endif // ES_CORE_PROFILER_H
@@ -1,5 +1,6 @@
 #include "Scripting.h"
 #include "Log.h"
+#include "PersistenceManager.h"
 #include "platform.h"
 #include "utils/FileSystemUtil.h"
 
@@ -9,6 +10,7 @@ namespace Scripting
 	{
 		LOG(LogDebug) << "fireEvent: " << eventName << " " << arg1 << " " << arg2;
 
+        bool flushed = false;
         std::list<std::string> scriptDirList;
         std::string test;
 
@@ -28,6 +30,14 @@ namespace Scripting
                 // append folder to path
                 std::string script = *it + " \"" + arg1 + "\" \"" + arg2 + "\"";
                 LOG(LogDebug) << "  executing: " << script;
+
+                // scripts block the main loop and may read the settings or gamelists, write the pending saves first
+                if (!flushed)
+                {
+                    PersistenceManager::getInstance()->flush();
+                    flushed = true;
+                }
+
                 runSystemCommand(script, "", NULL);
             }
         }
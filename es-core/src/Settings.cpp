@@ -2,10 +2,12 @@
 
 #include "utils/FileSystemUtil.h"
 #include "Log.h"
+#include "PersistenceManager.h"
 #include "Scripting.h"
 #include "platform.h"
 #include <pugixml/src/pugixml.hpp>
 #include <algorithm>
+#include <sstream>
 #include <vector>
 
 Settings* Settings::sInstance = NULL;
@@ -21,6 +23,7 @@ std::vector<const char*> settings_dont_save {
 	{ "ForceKid" },
 	{ "ForceKiosk" },
 	{ "IgnoreGamelist" },
+	{ "ForceRescan" },
 	{ "HideConsole" },
 	{ "ShowExit" },
 	{ "SplashScreen" },
@@ -75,8 +78,15 @@ void Settings::setDefaults()
 
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
+	mBoolMap["ScanCache"] = true;
+	mBoolMap["GamelistSnapshot"] = true;
+	mBoolMap["ThumbnailCache"] = true;
+	mBoolMap["ForceRescan"] = false;
 	mBoolMap["ShowHiddenFiles"] = false;
 	mBoolMap["DrawFramerate"] = false;
+	mBoolMap["BatchRendering"] = true;
+	mBoolMap["SkipIdleFrames"] = true;
+	mBoolMap["Profiler"] = false;
 	mBoolMap["ShowExit"] = true;		
 
 #if WIN32
@@ -119,6 +129,7 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = 5*60*1000; // 5 minutes
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ThumbnailCacheSize"] = 200; // MB
 
 #if defined(_WIN32)
 	mIntMap["MaxVRAM"] = 256;
@@ -262,6 +273,21 @@ bool Settings::saveFile()
 	if (!mWasChanged)
 		return false;
 
+	// written in the background once the settings stop changing
+	PersistenceManager::getInstance()->markDirty("settings", [this] { return captureFile(); });
+
+	// scripts still get the events right away, Scripting writes the pending files before running them
+	Scripting::fireEvent("config-changed");
+	Scripting::fireEvent("settings-changed");
+
+	return true;
+}
+
+std::function<size_t(void)> Settings::captureFile()
+{
+	if (!mWasChanged)
+		return nullptr;
+
 	mWasChanged = false;
 
 	LOG(LogDebug) << "Settings::saveFile() : Saving Settings to file.";
@@ -296,12 +322,17 @@ bool Settings::saveFile()
 		node.append_attribute("value").set_value(iter->second.c_str());
 	}
 
-	doc.save_file(path.c_str());
+	std::ostringstream stream;
+	doc.save(stream);
+	std::string data = stream.str();
 
-	Scripting::fireEvent("config-changed");
-	Scripting::fireEvent("settings-changed");
+	return [path, data]() -> size_t
+	{
+		if (!PersistenceManager::writeFile(path, data))
+			return 0;
 
-	return true;
+		return data.size();
+	};
 }
 
 void Settings::loadFile()
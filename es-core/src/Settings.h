@@ -2,7 +2,9 @@
 #ifndef ES_CORE_SETTINGS_H
 #define ES_CORE_SETTINGS_H
 
+#include <functional>
 #include <map>
+#include <string>
 
 //This is a singleton for storing settings.
 class Settings
@@ -11,7 +13,7 @@ public:
 	static Settings* getInstance();
 
 	void loadFile();
-	bool saveFile();
+	bool saveFile(); // the file is written later in the background, see PersistenceManager
 
 	//You will get a warning if you try a get on a key that is not already present.
 	bool getBool(const std::string& name);
@@ -32,6 +34,9 @@ private:
 	//Clear everything and load default values.
 	void setDefaults();
 
+	// Serializes the settings, returns the function writing them
+	std::function<size_t(void)> captureFile();
+
 	std::map<std::string, bool> mBoolMap;
 	std::map<std::string, int> mIntMap;
 	std::map<std::string, float> mFloatMap;
@@ -3,18 +3,21 @@
 #include "components/HelpComponent.h"
 #include "components/ImageComponent.h"
 #include "resources/Font.h"
+#include "resources/TextureAtlas.h"
 #include "resources/TextureResource.h"
 #include "InputManager.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Scripting.h"
 #include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <SDL_events.h>
 #include "guis/GuiInfoPopup.h"
 #include "components/AsyncNotificationComponent.h"
 
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
+	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mTimeSinceLastRender(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
 {
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);	
@@ -22,6 +25,14 @@ Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCoun
 	mSplash = NULL;	
 }
 
+// Even when nothing reports changes, the screen is refreshed this often (ms)
+#define IDLE_REFRESH_INTERVAL 1000
+
+static std::atomic<bool> sDirty(true);
+static Uint32 sWakeEventType = (Uint32)-1;
+
+static std::mutex mNotificationMessagesLock;
+
 Window::~Window()
 {
 	delete mBackgroundOverlay;
@@ -42,6 +53,8 @@ void Window::pushGui(GuiComponent* gui)
 	}
 	mGuiStack.push_back(gui);
 	gui->updateHelpPrompts();
+
+	invalidate();
 }
 
 void Window::removeGui(GuiComponent* gui)
@@ -58,6 +71,7 @@ void Window::removeGui(GuiComponent* gui)
 				mGuiStack.back()->topWindow(true);
 			}
 
+			invalidate();
 			return;
 		}
 	}
@@ -84,9 +98,15 @@ bool Window::init(bool initRenderer)
 		}
 
 		InputManager::getInstance()->init();
+
+		// Pushed by invalidate() to wake up the main loop
+		if (sWakeEventType == (Uint32)-1)
+			sWakeEventType = SDL_RegisterEvents(1);
 	}
 	else
 		Renderer::activateWindow();
+
+	invalidate();
 		
 	ResourceManager::getInstance()->reloadAll();
 
@@ -130,6 +150,7 @@ void Window::deinit(bool deinitRenderer)
 
 	TextureResource::resetCache();
 	ResourceManager::getInstance()->unloadAll();
+	TextureAtlas::getInstance()->reset();
 
 	if (deinitRenderer)
 		Renderer::deinit();
@@ -137,12 +158,16 @@ void Window::deinit(bool deinitRenderer)
 
 void Window::textInput(const char* text)
 {
+	invalidate();
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
 
 void Window::input(InputConfig* config, Input input)
 {
+	invalidate();
+
 	if (mScreenSaver) {
 		if(mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool("ScreenSaverControls") &&
 		   (Settings::getInstance()->getString("ScreenSaverBehavior") == "random video"))
@@ -197,6 +222,18 @@ void Window::input(InputConfig* config, Input input)
 		// toggle TextComponent debug view with Ctrl-I
 		Settings::getInstance()->setBool("DebugImage", !Settings::getInstance()->getBool("DebugImage"));
 	}
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_p && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// toggle the profiler overlay with Ctrl-P
+		Settings::getInstance()->setBool("Profiler", !Settings::getInstance()->getBool("Profiler"));
+	}
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_j && SDL_GetModState() & KMOD_LCTRL && Profiler::isEnabled())
+	{
+		// write the last profiled frames as a Chrome trace with Ctrl-J
+		std::string path = Profiler::dump();
+		if (!path.empty())
+			displayNotificationMessage(path);
+	}
 	else
 	{
 		if (peekGui())
@@ -208,6 +245,9 @@ void Window::input(InputConfig* config, Input input)
 
 void Window::update(int deltaTime)
 {	
+	Profiler::setEnabled(Settings::getInstance()->getBool("Profiler"));
+	PROFILE_SCOPE("Window::update");
+
 	if(mNormalizeNextUpdate)
 	{
 		mNormalizeNextUpdate = false;
@@ -236,27 +276,111 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// texture decoding
+			TextureLoaderStats loader = TextureResource::getLoaderStats();
+			ss << "\nTex Queue: " << loader.queued[TEXTURE_PRIORITY_VISIBLE] << "/" << loader.queued[TEXTURE_PRIORITY_NEXT_PAGE] << "/" << loader.queued[TEXTURE_PRIORITY_PREFETCH] <<
+				  " Dropped: " << loader.dropped << " Decode: " << loader.decodeTime << "ms Visible: " << loader.visibleLatency << "ms";
+
+			// rendering
+			Renderer::Stats renderer = Renderer::getStats();
+			ss << "\nDraw calls: " << renderer.drawCalls << " (" << renderer.primitives << " draws, " << renderer.vertices << " vertices) CPU: " << renderer.cpuTime << "ms Atlas pages: " << TextureAtlas::getInstance()->getPageCount();
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
 		}
 
+		// below the framerate text
+		if(Profiler::isEnabled())
+			mProfilerText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(Profiler::getSummary(), 50.f, 50.f + mDefaultFonts.at(1)->getHeight() * 5, 0x00FF00FF));
+
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
 	}
 
 	mTimeSinceLastInput += deltaTime;
+	mTimeSinceLastRender += deltaTime;
 
 	if(peekGui())
+	{
+		ProfileScope scope(typeid(*peekGui()));
 		peekGui()->update(deltaTime);
+	}
 
 	// Update the screensaver
 	if (mScreenSaver)
 		mScreenSaver->update(deltaTime);
+
+	// Done here rather than in render() so it also happens while idle frames are skipped
+	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
+	{
+		startScreenSaver();
+
+		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
+		{
+			// go to sleep
+			if (mSleeping == false) {
+				mSleeping = true;
+				onSleep();
+			}
+		}
+	}
+}
+
+void Window::invalidate()
+{
+	if (sDirty.exchange(true))
+		return;
+
+	// The main loop may be waiting for events
+	if (sWakeEventType != (Uint32)-1)
+	{
+		SDL_Event event = {};
+		event.type = sWakeEventType;
+		SDL_PushEvent(&event);
+	}
+}
+
+bool Window::isDirty()
+{
+	if (sDirty || !Settings::getInstance()->getBool("SkipIdleFrames") || Settings::getInstance()->getBool("DrawFramerate") || Profiler::isEnabled())
+		return true;
+
+	// Animated on their own
+	if (mRenderScreenSaver || (mScreenSaver && mScreenSaver->isScreenSaverActive()))
+		return true;
+
+	{
+		std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
+		if (!mAsyncNotificationComponent.empty())
+			return true;
+	}
+
+	// Safety net for what doesn't report its changes
+	return mTimeSinceLastRender >= IDLE_REFRESH_INTERVAL;
+}
+
+int Window::getIdleTimeout()
+{
+	int timeout = IDLE_REFRESH_INTERVAL - mTimeSinceLastRender;
+
+	// Wake up in time to start the screensaver
+	int screensaverTime = Settings::getInstance()->getInt("ScreenSaverTime");
+	if (screensaverTime != 0 && screensaverTime - (int)mTimeSinceLastInput < timeout)
+		timeout = screensaverTime - (int)mTimeSinceLastInput;
+
+	return timeout < 1 ? 1 : timeout;
 }
 
 void Window::render()
 {
 	Transform4x4f transform = Transform4x4f::Identity();
 
+	// Whatever changes while rendering makes the next frame dirty again
+	sDirty = false;
+	mTimeSinceLastRender = 0;
+
+	PROFILE_SCOPE("Window::render");
+
 	mRenderedHelpPrompts = false;
 
 	// draw only bottom and top of GuiStack (if they are different)
@@ -265,7 +389,11 @@ void Window::render()
 		auto& bottom = mGuiStack.front();
 		auto& top = mGuiStack.back();
 
-		bottom->render(transform);
+		{
+			ProfileScope scope(typeid(*bottom));
+			bottom->render(transform);
+		}
+
 		if(bottom != top)
 		{
 			if (top->getValue() == "GuiMsgBox" && mGuiStack.size() > 2)
@@ -276,6 +404,8 @@ void Window::render()
 			}
 
 			mBackgroundOverlay->render(transform);
+
+			ProfileScope scope(typeid(*top));
 			top->render(transform);
 		}
 	}
@@ -292,9 +422,16 @@ void Window::render()
 		mDefaultFonts.at(1)->renderTextCache(mFrameDataText.get());
 	}
 
-	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
-	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
-		startScreenSaver();
+	if(Profiler::isEnabled())
+	{
+		Profiler::renderOverlay();
+
+		if(mProfilerText)
+		{
+			Renderer::setMatrix(Transform4x4f::Identity());
+			mDefaultFonts.at(1)->renderTextCache(mProfilerText.get());
+		}
+	}
 
 	// Always call the screensaver render function regardless of whether the screensaver is active
 	// or not because it may perform a fade on transition
@@ -304,18 +441,6 @@ void Window::render()
 		mInfoPopup->render(transform);
 
 	renderRegisteredNotificationComponents(transform);
-
-	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
-	{
-		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
-		{
-			// go to sleep
-			if (mSleeping == false) {
-				mSleeping = true;
-				onSleep();
-			}
-		}
-	}
 }
 
 void Window::normalizeNextUpdate()
@@ -589,8 +714,6 @@ void Window::renderScreenSaver()
 		mScreenSaver->renderScreenSaver();
 }
 
-static std::mutex mNotificationMessagesLock;
-
 void Window::displayNotificationMessage(std::string message, int duration)
 {
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
@@ -608,6 +731,8 @@ void Window::displayNotificationMessage(std::string message, int duration)
 	msg.first = message;
 	msg.second = duration;
 	mNotificationMessages.push_back(msg);
+
+	invalidate();
 }
 
 void Window::processNotificationMessages()
@@ -668,9 +793,12 @@ void Window::renderRegisteredNotificationComponents(const Transform4x4f& trans)
 
 void Window::postToUiThread(const std::function<void(Window*)>& func)
 {
-	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
+	{
+		std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
+		mFunctions.push_back(func);
+	}
 
-	mFunctions.push_back(func);
+	invalidate();
 }
 
 void Window::processPostedFunctions()
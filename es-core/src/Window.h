@@ -59,6 +59,13 @@ public:
 	void update(int deltaTime);
 	void render();
 
+	// Idle frames are not rendered : the main loop renders and swaps only when the screen is dirty.
+	// Anything changing on screen without an input (animations, videos, loaded textures...) calls invalidate(), from any thread.
+	static void invalidate();
+	bool isDirty();
+	// Milliseconds the main loop can wait for events before the next update is due
+	int getIdleTimeout();
+
 	bool init(bool initRenderer);
 	void deinit(bool deinitRenderer);
 
@@ -128,12 +135,14 @@ private:
 	int mAverageDeltaTime;
 
 	std::unique_ptr<TextCache> mFrameDataText;
+	std::unique_ptr<TextCache> mProfilerText;
 
 	bool mNormalizeNextUpdate;
 
 	bool mAllowSleep;
 	bool mSleeping;
 	unsigned int mTimeSinceLastInput;
+	int mTimeSinceLastRender;
 
 	bool mRenderedHelpPrompts;
 };
@@ -3,6 +3,7 @@
 #include "components/ImageComponent.h"
 #include "resources/ResourceManager.h"
 #include "Log.h"
+#include "Window.h"
 
 AnimatedImageComponent::AnimatedImageComponent(Window* window) : GuiComponent(window), mEnabled(false)
 {
@@ -60,6 +61,7 @@ void AnimatedImageComponent::update(int deltaTime)
 	while(mFrames.at(mCurrentFrame).second <= mFrameAccumulator)
 	{
 		mCurrentFrame++;
+		Window::invalidate();
 
 		if(mCurrentFrame == (int)mFrames.size())
 		{
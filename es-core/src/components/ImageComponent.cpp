@@ -7,6 +7,7 @@
 #include "ThemeData.h"
 
 #include "resources/TextureData.h"
+#include "Window.h"
 
 Vector2i ImageComponent::getTextureSize() const
 {
@@ -412,7 +413,17 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 		mVertices[2].col = mColorGradientHorizontal ? color : colorEnd;
 		mVertices[3].col = colorEnd;
 
-		Renderer::drawTriangleStrips(&mVertices[0], 4);
+		// Small static images are packed in an atlas, draw the part of it holding this one
+		const Vector4f& textureRect = mTexture->getTextureRect();
+
+		Renderer::Vertex vertices[4];
+		for (int i = 0; i < 4; i++)
+		{
+			vertices[i] = mVertices[i];
+			vertices[i].tex = Vector2f(textureRect.x() + mVertices[i].tex.x() * textureRect.z(), textureRect.y() + mVertices[i].tex.y() * textureRect.w());
+		}
+
+		Renderer::drawTriangleStrips(&vertices[0], 4);
 
 		if (mMirror.x() != 0 || mMirror.y() != 0)
 		{
@@ -424,30 +435,30 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 			const unsigned int colorT = Renderer::convertColor((mColorShift & 0xffffff00) + (unsigned char)(255.0*alpha));
 			const unsigned int colorB = Renderer::convertColor((mColorShift & 0xffffff00) + (unsigned char)(255.0*alpha2));
 
-			int h = mVertices[1].pos.y() - mVertices[0].pos.y();
+			int h = vertices[1].pos.y() - vertices[0].pos.y();
 			if (mReflectOnBorders)
 				h = mTargetSize.y();
 
 			Renderer::Vertex mirrorVertices[4];
 
 			mirrorVertices[0] = {
-				{ mVertices[0].pos.x(), mVertices[0].pos.y() + h },
-				{ mVertices[0].tex.x(), mVertices[1].tex.y() },
+				{ vertices[0].pos.x(), vertices[0].pos.y() + h },
+				{ vertices[0].tex.x(), vertices[1].tex.y() },
 				colorT };
 
 			mirrorVertices[1] = {
-				{ mVertices[1].pos.x(), mVertices[1].pos.y() + h },
-				{ mVertices[1].tex.x(), mVertices[0].tex.y() },
+				{ vertices[1].pos.x(), vertices[1].pos.y() + h },
+				{ vertices[1].tex.x(), vertices[0].tex.y() },
 				colorB };
 
 			mirrorVertices[2] = {
-				{ mVertices[2].pos.x(), mVertices[2].pos.y() + h },
-				{ mVertices[2].tex.x(), mVertices[3].tex.y() },
+				{ vertices[2].pos.x(), vertices[2].pos.y() + h },
+				{ vertices[2].tex.x(), vertices[3].tex.y() },
 				colorT };
 
 			mirrorVertices[3] = {
-				{ mVertices[3].pos.x(), mVertices[3].pos.y() + h },
-				{ mVertices[3].tex.x(), mVertices[2].tex.y() },
+				{ vertices[3].pos.x(), vertices[3].pos.y() + h },
+				{ vertices[3].tex.x(), vertices[2].tex.y() },
 				colorB };
 
 			Renderer::drawTriangleStrips(&mirrorVertices[0], 4);
@@ -485,6 +496,7 @@ void ImageComponent::fadeIn(bool textureLoaded)
 			// and is 1/4 second if running at 60 frames per second although the actual value is not
 			// that important
 			int opacity = mFadeOpacity + 255 / 15;
+			Window::invalidate();
 			// See if we've finished fading
 			if (opacity >= 255)
 			{
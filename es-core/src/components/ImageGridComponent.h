@@ -93,6 +93,8 @@ private:
 
 	bool mEntriesDirty;
 	int mLastCursor;
+	bool mScrollForward;
+	TextureLoadToken mLoadToken;
 	std::string mDefaultGameTexture;
 	std::string mDefaultFolderTexture;
 
@@ -150,6 +152,7 @@ ImageGridComponent<T>::ImageGridComponent(Window* window) : IList<ImageGridData,
 	mStartPosition = 0;	
 	mEntriesDirty = true;
 	mLastCursor = 0;
+	mScrollForward = true;
 	mDefaultGameTexture = ":/cartridge.svg";
 	mDefaultFolderTexture = ":/folder.svg";
 
@@ -549,6 +552,8 @@ void ImageGridComponent<T>::onCursorChanged(const CursorState& state)
 	if (mScrollLoop && diff == mEntries.size() - 1)
 		direction = !direction;
 
+	mScrollForward = direction;
+
 	int oldStart = mStartPosition;
 
 	float dimScrollable = isVertical() ? mGridDimension.y() - 2 * EXTRAITEMS : mGridDimension.x() - 2 * EXTRAITEMS;
@@ -692,6 +697,9 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 	if (!mTiles.size())
 		return;
 
+	// The textures the tiles asked for until now are stale, unless they are hinted again below
+	mLoadToken.next();
+
 	// Stop updating the tiles at highest scroll speed
 	if (mScrollTier == 3)
 	{
@@ -728,22 +736,26 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 		i++; img++;
 	}
 	
-	// Collect new textures
-	std::vector<std::shared_ptr<TextureResource>> newTextures;
-	for (int ti = 0; ti < (int)mTiles.size(); ti++)
+	// Decode the visible tiles first, then the buffer tiles in the scroll direction, then the ones left behind.
+	// Textures of the previous tiles that are not hinted again are dropped by the loader.
+	int dimOpposite = isVertical() ? mGridDimension.x() : mGridDimension.y();
+	if (dimOpposite > 0)
 	{
-		newTextures.push_back(mTiles.at(ti)->getTexture(true));
-		newTextures.push_back(mTiles.at(ti)->getTexture(false));
-	}
+		int lines = (int)mTiles.size() / dimOpposite;
 
-	// Compare old texture with new textures -> Remove missing from async queue if existing
-	for (auto tex : previousTextures)
-	{
-		if (tex == nullptr)
-			continue;
+		for (int ti = 0; ti < (int)mTiles.size(); ti++)
+		{
+			int line = ti / dimOpposite;
 
-		if (std::find(newTextures.cbegin(), newTextures.cend(), tex) == newTextures.cend())
-			TextureResource::cancelAsync(tex);
+			TextureLoadPriority priority = TEXTURE_PRIORITY_VISIBLE;
+			if (line < EXTRAITEMS)
+				priority = mScrollForward ? TEXTURE_PRIORITY_PREFETCH : TEXTURE_PRIORITY_NEXT_PAGE;
+			else if (line >= lines - EXTRAITEMS)
+				priority = mScrollForward ? TEXTURE_PRIORITY_NEXT_PAGE : TEXTURE_PRIORITY_PREFETCH;
+
+			TextureResource::setLoadHint(mTiles.at(ti)->getTexture(false), priority, mLoadToken);
+			TextureResource::setLoadHint(mTiles.at(ti)->getTexture(true), priority, mLoadToken);
+		}
 	}
 
 	if (updateSelectedState)
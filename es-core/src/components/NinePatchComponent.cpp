@@ -126,7 +126,23 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 	else if (mTexture->bind())
 	{
 		Renderer::setMatrix(trans);
-		Renderer::drawTriangleStrips(&mVertices[0], 6 * 9);
+
+		// Small static images are packed in an atlas, draw the part of it holding this one
+		const Vector4f& textureRect = mTexture->getTextureRect();
+		if (textureRect != Vector4f(0.0f, 0.0f, 1.0f, 1.0f))
+		{
+			Renderer::Vertex vertices[6 * 9];
+			for (int i = 0; i < 6 * 9; i++)
+			{
+				vertices[i] = mVertices[i];
+				vertices[i].tex = Vector2f(textureRect.x() + mVertices[i].tex.x() * textureRect.z(), textureRect.y() + mVertices[i].tex.y() * textureRect.w());
+			}
+
+			Renderer::drawTriangleStrips(&vertices[0], 6 * 9);
+		}
+		else
+			Renderer::drawTriangleStrips(&mVertices[0], 6 * 9);
+
 		Renderer::bindTexture(0);
 	}
 
@@ -2,6 +2,7 @@
 
 #include "math/Vector2i.h"
 #include "renderers/Renderer.h"
+#include "Window.h"
 
 #define AUTO_SCROLL_RESET_DELAY 3000 // ms to reset to top after we reach the bottom
 #define AUTO_SCROLL_DELAY 1000 // ms to wait before we start to scroll
@@ -72,6 +73,7 @@ void ScrollableContainer::update(int deltaTime)
 		{
 			mScrollPos += mScrollDir;
 			mAutoScrollAccumulator -= mAutoScrollSpeed;
+			Window::invalidate();
 		}
 	}
 
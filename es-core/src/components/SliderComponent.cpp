@@ -1,6 +1,8 @@
 #include "components/SliderComponent.h"
 
 #include "resources/Font.h"
+#include "Window.h"
+
 #define MOVE_REPEAT_DELAY 500
 #define MOVE_REPEAT_RATE 40
 
@@ -61,6 +63,7 @@ void SliderComponent::update(int deltaTime)
 		{
 			setValue(mValue + mMoveRate);
 			mMoveAccumulator -= MOVE_REPEAT_RATE;
+			Window::invalidate();
 		}
 	}
 	
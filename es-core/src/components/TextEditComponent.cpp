@@ -3,6 +3,7 @@
 #include "resources/Font.h"
 #include "utils/StringUtil.h"
 #include "EsLocale.h"
+#include "Window.h"
 
 #define TEXT_PADDING_HORIZ 10
 #define TEXT_PADDING_VERT 2
@@ -189,6 +190,10 @@ void TextEditComponent::update(int deltaTime)
 	if (mBlinkTime >= BLINKTIME)
 		mBlinkTime = 0;
 
+	// the cursor blinks
+	if (mEditing)
+		Window::invalidate();
+
 	updateCursorRepeat(deltaTime);
 	GuiComponent::update(deltaTime);
 }
@@ -357,6 +357,10 @@ void VideoComponent::update(int deltaTime)
 {
 	manageState();
 
+	// new video frames, or waiting for the delayed start
+	if (mIsPlaying || mStartDelayed)
+		Window::invalidate();
+
 	if (mIsPlaying)
 	{
 		// If the video start is delayed and there is less than the fade time then set the image fade
@@ -3,6 +3,7 @@
 #include "components/ComponentGrid.h"
 #include "components/NinePatchComponent.h"
 #include "components/TextComponent.h"
+#include "Window.h"
 #include <SDL_timer.h>
 
 GuiInfoPopup::GuiInfoPopup(Window* window, std::string message, int duration) :
@@ -81,6 +82,9 @@ void GuiInfoPopup::render(const Transform4x4f& /*parentTrans*/)
 		// if we're still supposed to be rendering it
 		Renderer::setMatrix(trans);
 		renderChildren(trans);
+
+		// the fade keeps changing until the popup is gone
+		Window::invalidate();
 	}
 }
 
@@ -265,6 +265,7 @@ void GuiInputConfig::update(int deltaTime)
 				ss << "HOLD FOR " << HOLD_TO_SKIP_MS/1000 - curSec << "S TO SKIP";
 				text->setText(ss.str());
 				text->setColor(ThemeData::getMenuTheme()->Text.color);
+				Window::invalidate();
 			}
 		}
 	}
@@ -51,7 +51,8 @@ GuiTextEditPopupKeyboard::GuiTextEditPopupKeyboard(Window* window, const std::st
 	addChild(&mBackground);
 	addChild(&mGrid);
 
-	mTitle = std::make_shared<TextComponent>(mWindow, Utils::String::toUpper(title), theme->Title.font, theme->Title.color, ALIGN_CENTER);
+	mTitleText = Utils::String::toUpper(title);
+	mTitle = std::make_shared<TextComponent>(mWindow, mTitleText, theme->Title.font, theme->Title.color, ALIGN_CENTER);
 
 	// Accept/Cancel/Delete/Space buttons
 	std::vector<std::shared_ptr<ButtonComponent> > buttons;
@@ -244,10 +245,31 @@ bool GuiTextEditPopupKeyboard::input(InputConfig* config, Input input)
 
 	return false;
 }
-/*
-void GuiTextEditPopupKeyboard::update(int deltatime) {
+void GuiTextEditPopupKeyboard::update(int deltatime)
+{
+	GuiComponent::update(deltatime);
+
+	if (mTextChangedCallback == nullptr)
+		return;
+
+	std::string value = mText->getValue();
+	if (value != mLastValue)
+		onTextChanged(value);
+}
+
+void GuiTextEditPopupKeyboard::setTextChangedCallback(const std::function<std::string(const std::string&)>& callback)
+{
+	mTextChangedCallback = callback;
+	onTextChanged(mText->getValue());
+}
 
-}*/
+void GuiTextEditPopupKeyboard::onTextChanged(const std::string& value)
+{
+	mLastValue = value;
+
+	std::string info = mTextChangedCallback(value);
+	mTitle->setText(info.empty() ? mTitleText : mTitleText + " (" + info + ")");
+}
 
 // Shifts the keys when user hits the shift button.
 void GuiTextEditPopupKeyboard::shiftKeys() 
@@ -13,10 +13,13 @@ public:
 		const std::function<void(const std::string&)>& okCallback, bool multiLine, const std::string acceptBtnText = "OK");
 
 	bool input(InputConfig* config, Input input);
-	//void update(int deltatime) override;
+	void update(int deltatime) override;
 	void onSizeChanged();
 	std::vector<HelpPrompt> getHelpPrompts() override;
 
+	// Called when the text changes, what it returns is shown next to the title (i.e. the number of results)
+	void setTextChangedCallback(const std::function<std::string(const std::string&)>& callback);
+
 private:
 	class KeyboardButton
 	{
@@ -33,6 +36,7 @@ private:
 	const Vector2f getButtonSize();
 
 	void shiftKeys();
+	void onTextChanged(const std::string& value);
 
 	NinePatchComponent mBackground;
 	ComponentGrid mGrid;
@@ -44,5 +48,9 @@ private:
 	
 	bool mMultiLine;
 	bool mShift = false;	
+
+	std::string mTitleText;
+	std::string mLastValue;
+	std::function<std::string(const std::string&)> mTextChangedCallback;
 };
 
@@ -26,9 +26,11 @@ void processQuitMode();
 #if defined(WIN32)
 #include <Windows.h>
 #include <intrin.h>
-#include "Log.h"
 #endif
 
+#include "Log.h"
+#include <chrono>
+
 #if !defined(TRACE)
 #if defined(WIN32) && defined(_DEBUG)	
 	#include <sstream>
@@ -44,26 +46,23 @@ void processQuitMode();
 #endif
 #endif
 
+// Logs the time spent between its construction and its destruction
 class StopWatch
 {
 public:
-	StopWatch(std::string name)
+	StopWatch(std::string name) : mName(name), mStart(std::chrono::steady_clock::now())
 	{
-#if defined(WIN32)
-		mName = name;
-		mTicks = ::GetTickCount();
-#endif
 	}
 
 	~StopWatch()
 	{
-#if defined(WIN32)
-		int now = ::GetTickCount();
-
-		mTicks = now - mTicks;
+		int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStart).count();
 
-		LOG(LogInfo) << mName << " " << mTicks << " ms" << " on CPU " << GetCurrentProcessorNumber();
-		TRACE(mName << " " << mTicks << " ms" << " on CPU " << GetCurrentProcessorNumber());
+#if defined(WIN32)
+		LOG(LogInfo) << mName << " " << ms << " ms" << " on CPU " << GetCurrentProcessorNumber();
+		TRACE(mName << " " << ms << " ms" << " on CPU " << GetCurrentProcessorNumber());
+#else
+		LOG(LogInfo) << mName << " " << ms << " ms";
 #endif
 	}
 
@@ -77,7 +76,7 @@ private:
 		return (unsigned)CPUInfo[1] >> 24;
 	}
 #endif
-	int mTicks;
 	std::string mName;
+	std::chrono::steady_clock::time_point mStart;
 };
 #endif // ES_CORE_PLATFORM_H
@@ -5,10 +5,12 @@
 #include "resources/ResourceManager.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 
 #include <SDL.h>
 #include <stack>
+#include <vector>
 
 namespace Renderer
 {
@@ -27,6 +29,23 @@ namespace Renderer
 
 	static Vector2i			sdlWindowPosition  = Vector2i(SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED);
 
+	// Batching : pending triangles, all using the same texture and blending
+	static std::vector<Vertex> batchVertices;
+	static unsigned int        batchTexture       = 0;
+	static Blend::Factor       batchSrcBlend      = Blend::SRC_ALPHA;
+	static Blend::Factor       batchDstBlend      = Blend::ONE_MINUS_SRC_ALPHA;
+	static bool                batchEnabled       = true;
+	static unsigned int        currentTexture     = 0;
+	static Transform4x4f       currentMatrix      = Transform4x4f::Identity();
+	static std::vector<Vector2f> transformedPos;
+
+	// Flushed before growing over this
+	static const size_t        maxBatchVertices   = 6 * 4096;
+
+	static Stats               frameStats;
+	static Stats               lastFrameStats;
+	static Uint64              frameStart         = 0;
+
 	static void setIcon()
 	{
 		size_t                     width   = 0;
@@ -169,6 +188,9 @@ namespace Renderer
 		if(!createWindow())
 			return false;
 
+		batchEnabled = Settings::getInstance()->getBool("BatchRendering");
+		batchVertices.reserve(maxBatchVertices);
+
 		Transform4x4f projection = Transform4x4f::Identity();
 		Rect          viewport   = Rect(0, 0, 0, 0);
 
@@ -270,6 +292,7 @@ namespace Renderer
 		clipStack.push(box);
 		nativeClipStack.push(Rect(_pos.x(), _pos.y(), _size.x(), _size.y()));
 
+		flush();
 		setScissor(box);
 
 	} // pushClipRect
@@ -285,6 +308,8 @@ namespace Renderer
 		clipStack.pop();
 		nativeClipStack.pop();
 
+		flush();
+
 		if(clipStack.empty()) setScissor(Rect(0, 0, 0, 0));
 		else                  setScissor(clipStack.top());
 
@@ -358,6 +383,138 @@ namespace Renderer
 
 	} // drawRect
 
+	void bindTexture(const unsigned int _texture)
+	{
+		// Applied when the batch using it is flushed
+		currentTexture = _texture;
+
+	} // bindTexture
+
+	void setMatrix(const Transform4x4f& _matrix)
+	{
+		currentMatrix = _matrix;
+		currentMatrix.round();
+
+	} // setMatrix
+
+	static void transformVertices(const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		// Only x and y are kept, the projection is orthographic
+		const float* tm = (const float*)&currentMatrix;
+
+		transformedPos.resize(_numVertices);
+
+		for(unsigned int i = 0; i < _numVertices; ++i)
+		{
+			const float x = _vertices[i].pos.x();
+			const float y = _vertices[i].pos.y();
+
+			transformedPos[i] = Vector2f(tm[0] * x + tm[4] * y + tm[12], tm[1] * x + tm[5] * y + tm[13]);
+		}
+
+	} // transformVertices
+
+	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_numVertices < 2)
+			return;
+
+		// Lines are rare (grid separators), they are not batched
+		flush();
+		transformVertices(_vertices, _numVertices);
+
+		std::vector<Vertex> vertices(_vertices, _vertices + _numVertices);
+		for(unsigned int i = 0; i < _numVertices; ++i)
+			vertices[i].pos = transformedPos[i];
+
+		useTexture(currentTexture);
+		drawArrays(vertices.data(), _numVertices, Primitive::LINES, _srcBlendFactor, _dstBlendFactor);
+
+		frameStats.drawCalls++;
+		frameStats.primitives++;
+		frameStats.vertices += _numVertices;
+
+	} // drawLines
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_numVertices < 3)
+			return;
+
+		const size_t numTriangleVertices = (_numVertices - 2) * 3;
+
+		if(!batchVertices.empty() && (batchTexture != currentTexture || batchSrcBlend != _srcBlendFactor || batchDstBlend != _dstBlendFactor || batchVertices.size() + numTriangleVertices > maxBatchVertices))
+			flush();
+
+		batchTexture  = currentTexture;
+		batchSrcBlend = _srcBlendFactor;
+		batchDstBlend = _dstBlendFactor;
+
+		transformVertices(_vertices, _numVertices);
+
+		// Strips can't be concatenated, they are converted to triangle lists
+		const size_t first = batchVertices.size();
+		batchVertices.resize(first + numTriangleVertices);
+
+		Vertex* out = &batchVertices[first];
+		for(unsigned int i = 2; i < _numVertices; ++i)
+		{
+			for(unsigned int j = i - 2; j <= i; ++j)
+			{
+				out->pos = transformedPos[j];
+				out->tex = _vertices[j].tex;
+				out->col = _vertices[j].col;
+				++out;
+			}
+		}
+
+		frameStats.primitives++;
+
+		if(!batchEnabled)
+			flush();
+
+	} // drawTriangleStrips
+
+	void flush()
+	{
+		if(batchVertices.empty())
+			return;
+
+		PROFILE_SCOPE("Renderer::flush");
+
+		useTexture(batchTexture);
+		drawArrays(batchVertices.data(), (unsigned int)batchVertices.size(), Primitive::TRIANGLES, batchSrcBlend, batchDstBlend);
+
+		frameStats.drawCalls++;
+		frameStats.vertices += (unsigned int)batchVertices.size();
+
+		batchVertices.clear();
+
+	} // flush
+
+	void swapBuffers()
+	{
+		flush();
+
+		const Uint64 now = SDL_GetPerformanceCounter();
+		if(frameStart != 0)
+			frameStats.cpuTime = (float)((now - frameStart) * 1000.0 / SDL_GetPerformanceFrequency());
+
+		lastFrameStats = frameStats;
+		frameStats     = Stats();
+
+		{
+			PROFILE_SCOPE("Renderer::swapWindow");
+			swapWindow();
+		}
+
+		// The time waiting for vsync is not CPU time
+		frameStart = SDL_GetPerformanceCounter();
+
+	} // swapBuffers
+
+	Stats getStats() { return lastFrameStats; }
+
 	SDL_Window* getSDLWindow()     { return sdlWindow; }
 	int         getWindowWidth()   { return windowWidth; }
 	int         getWindowHeight()  { return windowHeight; }
@@ -40,6 +40,17 @@ namespace Renderer
 
 	} // Texture::
 
+	namespace Primitive
+	{
+		enum Type
+		{
+			LINES     = 0,
+			TRIANGLES = 1
+
+		}; // Type
+
+	} // Primitive::
+
 	struct Rect
 	{
 		Rect(const int _x, const int _y, const int _w, const int _h) : x(_x), y(_y), w(_w), h(_h) { }
@@ -62,6 +73,17 @@ namespace Renderer
 
 	}; // Vertex
 
+	struct Stats
+	{
+		Stats() : drawCalls(0), primitives(0), vertices(0), cpuTime(0.0f) { }
+
+		unsigned int drawCalls;  // draw calls sent to the driver
+		unsigned int primitives; // drawLines / drawTriangleStrips calls made by the components
+		unsigned int vertices;
+		float        cpuTime;    // ms spent between two swapBuffers
+
+	}; // Stats
+
 	bool        init            ();
 	void        deinit          ();
 	void        pushClipRect    (const Vector2i& _pos, const Vector2i& _size);
@@ -69,6 +91,16 @@ namespace Renderer
 	void        drawRect        (const float _x, const float _y, const float _w, const float _h, const unsigned int _color, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
 	void        drawRect        (const float   _x, const float   _y, const float   _w, const float   _h, const unsigned int _color, const unsigned int _colorEnd, bool horizontalGradient = false, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
 
+	// Draws are batched : vertices are transformed on the CPU and consecutive draws with the same texture
+	// and blending are sent in a single draw call. flush() sends what is pending.
+	void        bindTexture       (const unsigned int _texture);
+	void        drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void        drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void        setMatrix         (const Transform4x4f& _matrix);
+	void        flush             ();
+	void        swapBuffers       ();
+	Stats       getStats          (); // of the last frame
+
 	SDL_Window* getSDLWindow    ();
 	int         getWindowWidth  ();
 	int         getWindowHeight ();
@@ -87,15 +119,13 @@ namespace Renderer
 	unsigned int createTexture     (const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data);
 	void         destroyTexture    (const unsigned int _texture);
 	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data);
-	void         bindTexture       (const unsigned int _texture);
-	void         drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
-	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void         useTexture        (const unsigned int _texture);
+	void         drawArrays        (const Vertex* _vertices, const unsigned int _numVertices, const Primitive::Type _primitive, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor);
 	void         setProjection     (const Transform4x4f& _projection);
-	void         setMatrix         (const Transform4x4f& _matrix);
 	void         setViewport       (const Rect& _viewport);
 	void         setScissor        (const Rect& _scissor);
 	void         setSwapInterval   ();
-	void         swapBuffers       ();
+	void         swapWindow        ();
 
 	// FCA methods
 	bool         isClippingEnabled();
@@ -42,6 +42,17 @@ namespace Renderer
 
 	} // convertTextureType
 
+	static GLenum convertPrimitiveType(const Primitive::Type _type)
+	{
+		switch(_type)
+		{
+			case Primitive::LINES:     { return GL_LINES;     } break;
+			case Primitive::TRIANGLES: { return GL_TRIANGLES; } break;
+			default:                   { return GL_TRIANGLES; }
+		}
+
+	} // convertPrimitiveType
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -80,6 +91,10 @@ namespace Renderer
 
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+		// The vertices are transformed on the CPU before being batched
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+
 		std::string glExts = (const char*)glGetString(GL_EXTENSIONS);
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (glExts.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
@@ -99,7 +114,7 @@ namespace Renderer
 		unsigned int texture;
 
 		glGenTextures(1, &texture);
-		bindTexture(texture);
+		useTexture(texture);
 
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
@@ -118,13 +133,19 @@ namespace Renderer
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		// Pending draws may still use it
+		flush();
+
 		glDeleteTextures(1, &_texture);
 
 	} // destroyTexture
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		bindTexture(_texture);
+		// Pending draws must use the previous content
+		flush();
+
+		useTexture(_texture);
 
 		if (_x == -1 && _y == -1)
 		{
@@ -134,43 +155,20 @@ namespace Renderer
 		else
 			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
 
-		bindTexture(0);
+		useTexture(0);
 
 	} // updateTexture
 
-	void bindTexture(const unsigned int _texture)
+	void useTexture(const unsigned int _texture)
 	{
 		glBindTexture(GL_TEXTURE_2D, _texture);
 
 		if(_texture == 0) glDisable(GL_TEXTURE_2D);
 		else              glEnable(GL_TEXTURE_2D);
 
-	} // bindTexture
-
-	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
-	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+	} // useTexture
 
-		glDrawArrays(GL_LINES, 0, _numVertices);
-
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
-
-	} // drawLines
-
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawArrays(const Vertex* _vertices, const unsigned int _numVertices, const Primitive::Type _primitive, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
 		glEnable(GL_BLEND);
 		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
@@ -183,7 +181,7 @@ namespace Renderer
 		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
 		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
 
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
+		glDrawArrays(convertPrimitiveType(_primitive), 0, _numVertices);
 
 		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -191,7 +189,7 @@ namespace Renderer
 
 		glDisable(GL_BLEND);
 
-	} // drawTriangleStrips
+	} // drawArrays
 
 	void setProjection(const Transform4x4f& _projection)
 	{
@@ -200,15 +198,6 @@ namespace Renderer
 
 	} // setProjection
 
-	void setMatrix(const Transform4x4f& _matrix)
-	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
-		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf((GLfloat*)&matrix);
-
-	} // setMatrix
-
 	void setViewport(const Rect& _viewport)
 	{
 		// glViewport starts at the bottom left of the window
@@ -250,7 +239,7 @@ namespace Renderer
 
 	} // setSwapInterval
 
-	void swapBuffers()
+	void swapWindow()
 	{
 #ifdef WIN32		
 		glFlush();
@@ -266,7 +255,7 @@ namespace Renderer
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	} // swapBuffers
+	} // swapWindow
 
 } // Renderer::
 
@@ -4,6 +4,7 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "Profiler.h"
 
 #ifdef WIN32
 #include <Windows.h>
@@ -349,6 +350,8 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	}
 
 	// nope, need to make a glyph
+	PROFILE_SCOPE("Font::rasterizeGlyph");
+
 	FT_Face face = getFaceForChar(id);
 	if(!face)
 	{
@@ -404,6 +407,8 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 // completely recreate the texture data for all textures based on mGlyphs information
 void Font::rebuildTextures()
 {
+	PROFILE_SCOPE("Font::rebuildTextures");
+
 	// recreate OpenGL textures
 	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
 		it->initTexture();
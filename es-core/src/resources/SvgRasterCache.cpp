@@ -0,0 +1,176 @@
+#include "resources/SvgRasterCache.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <nanosvg/nanosvg.h>
+#include <nanosvg/nanosvgrast.h>
+#include <string.h>
+
+#define DPI 96
+
+// Parsed images kept at most, theme SVGs are a few dozens
+#define SVG_IMAGE_CACHE_COUNT	256
+// Memory used by the bitmaps kept in memory, in bytes
+#define SVG_BITMAP_CACHE_SIZE	(16 * 1024 * 1024)
+
+namespace
+{
+	struct RasterizerDeleter
+	{
+		void operator()(NSVGrasterizer* rasterizer) { nsvgDeleteRasterizer(rasterizer); }
+	};
+}
+
+SvgRasterCache* SvgRasterCache::getInstance()
+{
+	// Never destroyed, textures may still be rasterized while static objects are destroyed
+	static SvgRasterCache* sInstance = new SvgRasterCache();
+	return sInstance;
+}
+
+SvgRasterCache::SvgRasterCache() : mBitmapSize(0)
+{
+}
+
+std::shared_ptr<NSVGimage> SvgRasterCache::getImage(const std::string& path)
+{
+	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+
+	long long mtime = Utils::FileSystem::getModificationTime(rm->getResourcePath(path));
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = mImages.find(path);
+		if (it != mImages.cend() && it->second.mtime == mtime)
+			return it->second.image;
+	}
+
+	const ResourceData data = rm->getFileData(path);
+	if (data.ptr == nullptr || data.length == 0)
+		return nullptr;
+
+	// nsvgParse expects a modifiable, null-terminated string
+	std::string copy((const char*)data.ptr.get(), data.length);
+
+	NSVGimage* svgImage = nsvgParse(&copy[0], "px", DPI);
+	if (!svgImage)
+	{
+		LOG(LogError) << "Error parsing SVG image \"" << path << "\"";
+		return nullptr;
+	}
+
+	std::shared_ptr<NSVGimage> image(svgImage, nsvgDelete);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (mImages.size() >= SVG_IMAGE_CACHE_COUNT && mImages.find(path) == mImages.cend())
+		mImages.erase(mImages.begin());
+
+	ImageEntry& entry = mImages[path];
+	entry.image = image;
+	entry.mtime = mtime;
+
+	return image;
+}
+
+unsigned char* SvgRasterCache::rasterize(NSVGimage* image, float scale, size_t width, size_t height)
+{
+	// Creating a rasterizer allocates its edge and span buffers, keep one per thread
+	static thread_local std::unique_ptr<NSVGrasterizer, RasterizerDeleter> sRasterizer;
+	if (sRasterizer == nullptr)
+		sRasterizer.reset(nsvgCreateRasterizer());
+
+	unsigned char* dataRGBA = new unsigned char[width * height * 4];
+	nsvgRasterize(sRasterizer.get(), image, 0, 0, scale, dataRGBA, (int)width, (int)height, (int)width * 4);
+
+	return dataRGBA;
+}
+
+unsigned char* SvgRasterCache::getBitmap(const std::string& path, const std::string& variant, ThumbnailInfo& info)
+{
+	std::string key = path + "|" + variant;
+
+	// The resources can be overridden in the home folder, the entries are keyed by the file really used
+	std::string filePath = ResourceManager::getInstance()->getResourcePath(path);
+	long long mtime = Utils::FileSystem::getModificationTime(filePath);
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = mBitmapLookup.find(key);
+		if (it != mBitmapLookup.cend() && it->second->filePath == filePath && it->second->mtime == mtime)
+		{
+			// Move it to the top
+			mBitmaps.splice(mBitmaps.begin(), mBitmaps, it->second);
+
+			const BitmapEntry& entry = *it->second;
+			size_t size = entry.info.width * entry.info.height * 4;
+
+			unsigned char* data = new unsigned char[size];
+			memcpy(data, entry.data.get(), size);
+
+			info = entry.info;
+			return data;
+		}
+	}
+
+	if (filePath.empty() || filePath[0] == ':' || !ThumbnailCache::isEnabled())
+		return nullptr;
+
+	return ThumbnailCache::getInstance()->load(filePath, "svg|" + variant, info);
+}
+
+void SvgRasterCache::putBitmap(const std::string& path, const std::string& variant, const unsigned char* data, const ThumbnailInfo& info)
+{
+	size_t size = info.width * info.height * 4;
+	if (data == nullptr || size == 0)
+		return;
+
+	std::string filePath = ResourceManager::getInstance()->getResourcePath(path);
+	long long mtime = Utils::FileSystem::getModificationTime(filePath);
+
+	if (size <= SVG_BITMAP_CACHE_SIZE / 4)
+	{
+		std::string key = path + "|" + variant;
+
+		std::shared_ptr<unsigned char> copy(new unsigned char[size], std::default_delete<unsigned char[]>());
+		memcpy(copy.get(), data, size);
+
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = mBitmapLookup.find(key);
+		if (it != mBitmapLookup.cend())
+		{
+			mBitmapSize -= it->second->info.width * it->second->info.height * 4;
+			mBitmaps.erase(it->second);
+			mBitmapLookup.erase(it);
+		}
+
+		BitmapEntry entry;
+		entry.key = key;
+		entry.filePath = filePath;
+		entry.mtime = mtime;
+		entry.data = copy;
+		entry.info = info;
+
+		mBitmaps.push_front(entry);
+		mBitmapLookup[key] = mBitmaps.begin();
+		mBitmapSize += size;
+
+		// Drop the least recently used ones
+		while (mBitmapSize > SVG_BITMAP_CACHE_SIZE && !mBitmaps.empty())
+		{
+			const BitmapEntry& last = mBitmaps.back();
+			mBitmapSize -= last.info.width * last.info.height * 4;
+			mBitmapLookup.erase(last.key);
+			mBitmaps.pop_back();
+		}
+	}
+
+	if (filePath.empty() || filePath[0] == ':' || !ThumbnailCache::isEnabled())
+		return;
+
+	ThumbnailCache::getInstance()->save(filePath, "svg|" + variant, data, info);
+}
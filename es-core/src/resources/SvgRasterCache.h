@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
+#define ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
+
+#include "resources/ThumbnailCache.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct NSVGimage;
+
+// Avoids parsing and rasterizing the same SVG files again and again (theme reloads, texture evictions...)
+//
+// Parsed images are kept per file, rasterizers are kept per thread, and finished bitmaps are kept per file and
+// rasterization parameters : in memory up to a small budget, then on disk through the ThumbnailCache.
+class SvgRasterCache
+{
+public:
+	static SvgRasterCache* getInstance();
+
+	// Parsed image of a file, parsed again only if the file changed. Rasterizing doesn't modify it, threads can share it.
+	std::shared_ptr<NSVGimage> getImage(const std::string& path);
+
+	// Rasterizes with the calling thread's rasterizer, returns new[] RGBA pixels
+	static unsigned char* rasterize(NSVGimage* image, float scale, size_t width, size_t height);
+
+	// Returns a new[] copy of the bitmap stored for path and variant, nullptr if there is none
+	unsigned char* getBitmap(const std::string& path, const std::string& variant, ThumbnailInfo& info);
+	void putBitmap(const std::string& path, const std::string& variant, const unsigned char* data, const ThumbnailInfo& info);
+
+private:
+	SvgRasterCache();
+
+	struct ImageEntry
+	{
+		std::shared_ptr<NSVGimage>	image;
+		long long					mtime;
+	};
+
+	struct BitmapEntry
+	{
+		std::string						key;
+		std::string						filePath;
+		long long						mtime;
+		std::shared_ptr<unsigned char>	data;
+		ThumbnailInfo					info;
+	};
+
+	typedef std::list<BitmapEntry> BitmapList;
+
+	std::mutex										mLock;
+	std::unordered_map<std::string, ImageEntry>		mImages;
+
+	BitmapList										mBitmaps; // most recently used first
+	std::unordered_map<std::string, BitmapList::iterator>	mBitmapLookup;
+	size_t											mBitmapSize;
+};
+
+#endif // ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
@@ -0,0 +1,233 @@
+#include "resources/TextureAtlas.h"
+
+#include "renderers/Renderer.h"
+#include "resources/TextureData.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include "ThemeData.h"
+#include <string.h>
+
+// Pages are square, 1024 is supported by every GLES device
+#define ATLAS_PAGE_SIZE		1024
+#define ATLAS_MAX_PAGES		8
+// Bigger images keep their own texture
+#define ATLAS_MAX_IMAGE		256
+// Border around every image, copied from its edges so linear filtering doesn't sample the neighbours
+#define ATLAS_PADDING		1
+
+TextureAtlas* TextureAtlas::getInstance()
+{
+	static TextureAtlas* sInstance = new TextureAtlas();
+	return sInstance;
+}
+
+TextureAtlas::TextureAtlas() : mThemePathKnown(false)
+{
+}
+
+bool TextureAtlas::isStaticImage(const std::string& path)
+{
+	if (path.empty())
+		return false;
+
+	if (path[0] == ':')
+		return true;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (!mThemePathKnown)
+	{
+		mThemePathKnown = true;
+		mThemePath = "";
+
+		std::map<std::string, ThemeSet> themeSets = ThemeData::getThemeSets();
+		if (!themeSets.empty())
+		{
+			std::map<std::string, ThemeSet>::const_iterator set = themeSets.find(Settings::getInstance()->getString("ThemeSet"));
+			if (set == themeSets.cend())
+				set = themeSets.cbegin();
+
+			mThemePath = Utils::FileSystem::getCanonicalPath(set->second.path) + "/";
+		}
+	}
+
+	return !mThemePath.empty() && Utils::String::startsWith(path, mThemePath);
+}
+
+bool TextureAtlas::allocate(Page& page, int width, int height, int& x, int& y)
+{
+	// Room left in the current shelf
+	if (page.cursorX + width <= ATLAS_PAGE_SIZE && height <= page.shelfHeight)
+	{
+		x = page.cursorX;
+		y = page.shelfY;
+		page.cursorX += width;
+		return true;
+	}
+
+	// The current shelf is empty, it can grow
+	if (page.cursorX == 0 && page.shelfY + height <= ATLAS_PAGE_SIZE)
+	{
+		x = 0;
+		y = page.shelfY;
+		page.shelfHeight = height;
+		page.cursorX = width;
+		return true;
+	}
+
+	// Open a new shelf below
+	int shelfY = page.shelfY + page.shelfHeight;
+	if (shelfY + height > ATLAS_PAGE_SIZE)
+		return false;
+
+	page.shelfY = shelfY;
+	page.shelfHeight = height;
+	page.cursorX = width;
+
+	x = 0;
+	y = shelfY;
+	return true;
+}
+
+bool TextureAtlas::add(TextureData* data, const unsigned char* dataRGBA, size_t width, size_t height, unsigned int& textureId, Vector4f& rect)
+{
+	if (dataRGBA == nullptr || width == 0 || height == 0 || width > ATLAS_MAX_IMAGE || height > ATLAS_MAX_IMAGE)
+		return false;
+
+	const int paddedWidth = (int)width + ATLAS_PADDING * 2;
+	const int paddedHeight = (int)height + ATLAS_PADDING * 2;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (mImages.find(data) != mImages.cend())
+		return false;
+
+	int x = 0;
+	int y = 0;
+	size_t pageIndex = mPages.size();
+
+	for (size_t i = 0; i < mPages.size(); i++)
+	{
+		Page& page = mPages[i];
+
+		// Every image of the page has been released, start it over
+		if (page.images == 0)
+		{
+			page.shelfY = 0;
+			page.shelfHeight = 0;
+			page.cursorX = 0;
+		}
+
+		if (allocate(page, paddedWidth, paddedHeight, x, y))
+		{
+			pageIndex = i;
+			break;
+		}
+	}
+
+	if (pageIndex == mPages.size())
+	{
+		if (mPages.size() >= ATLAS_MAX_PAGES)
+			return false;
+
+		std::vector<unsigned char> empty(ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4, 0);
+
+		Page page;
+		page.textureId = Renderer::createTexture(Renderer::Texture::RGBA, true, false, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, empty.data());
+		page.shelfY = 0;
+		page.shelfHeight = 0;
+		page.cursorX = 0;
+		page.images = 0;
+
+		if (page.textureId == 0)
+			return false;
+
+		allocate(page, paddedWidth, paddedHeight, x, y);
+		mPages.push_back(page);
+
+		LOG(LogDebug) << "TextureAtlas : page " << mPages.size() << " created";
+	}
+
+	// Copy the image with its edges extruded into the padding
+	std::vector<unsigned char> padded(paddedWidth * paddedHeight * 4);
+
+	for (int row = 0; row < paddedHeight; row++)
+	{
+		int srcRow = row - ATLAS_PADDING;
+		if (srcRow < 0) srcRow = 0;
+		if (srcRow >= (int)height) srcRow = (int)height - 1;
+
+		const unsigned char* src = dataRGBA + srcRow * width * 4;
+		unsigned char*       dst = padded.data() + row * paddedWidth * 4;
+
+		for (int p = 0; p < ATLAS_PADDING; p++)
+		{
+			memcpy(dst + p * 4, src, 4);
+			memcpy(dst + (ATLAS_PADDING + width + p) * 4, src + (width - 1) * 4, 4);
+		}
+
+		memcpy(dst + ATLAS_PADDING * 4, src, width * 4);
+	}
+
+	Page& page = mPages[pageIndex];
+	Renderer::updateTexture(page.textureId, Renderer::Texture::RGBA, x, y, paddedWidth, paddedHeight, padded.data());
+	page.images++;
+
+	mImages[data] = pageIndex;
+
+	textureId = page.textureId;
+	rect = Vector4f(
+		(float)(x + ATLAS_PADDING) / ATLAS_PAGE_SIZE,
+		(float)(y + ATLAS_PADDING) / ATLAS_PAGE_SIZE,
+		(float)width / ATLAS_PAGE_SIZE,
+		(float)height / ATLAS_PAGE_SIZE);
+
+	return true;
+}
+
+void TextureAtlas::remove(TextureData* data)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mImages.find(data);
+	if (it == mImages.cend())
+		return;
+
+	// The space is reused once the whole page is free
+	mPages[it->second].images--;
+	mImages.erase(it);
+}
+
+void TextureAtlas::reset()
+{
+	std::vector<TextureData*> images;
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		for (auto it = mImages.cbegin(); it != mImages.cend(); ++it)
+			images.push_back(it->first);
+	}
+
+	// They are packed again the next time they are bound
+	for (auto data : images)
+		data->releaseVRAM();
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	for (auto page : mPages)
+		Renderer::destroyTexture(page.textureId);
+
+	mPages.clear();
+	mImages.clear();
+
+	// The theme set may have changed
+	mThemePathKnown = false;
+}
+
+size_t TextureAtlas::getPageCount()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	return mPages.size();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+#define ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+
+#include "math/Vector4f.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TextureData;
+
+// Packs small static images (internal resources, theme icons and logos) into shared textures.
+//
+// Images are copied to a page the first time they are uploaded, instead of getting their own texture : the
+// renderer can draw them without switching textures, and the driver deals with a few big textures instead of
+// hundreds of small ones. Pages are filled with shelves, and emptied pages are reused. reset() drops everything
+// when the theme changes, the images are added again when they are bound.
+class TextureAtlas
+{
+public:
+	static TextureAtlas* getInstance();
+
+	// Internal resources and files of the current theme set, gamelist media are never packed
+	bool isStaticImage(const std::string& path);
+
+	// Copies width x height RGBA pixels to a page. Returns false if the image is too big or the pages are full,
+	// else the page texture and the image rectangle in it (x, y, w, h in texture coordinates).
+	bool add(TextureData* data, const unsigned char* dataRGBA, size_t width, size_t height, unsigned int& textureId, Vector4f& rect);
+	void remove(TextureData* data);
+
+	// Releases the packed images and destroys the pages. Must be called from the render thread.
+	void reset();
+
+	size_t getPageCount();
+
+private:
+	TextureAtlas();
+
+	struct Page
+	{
+		unsigned int	textureId;
+		int				shelfY;		 // top of the current shelf
+		int				shelfHeight;
+		int				cursorX;	 // first free column in the current shelf
+		int				images;		 // packed images still in use
+	};
+
+	bool allocate(Page& page, int width, int height, int& x, int& y);
+
+	std::mutex									mLock;
+	std::vector<Page>							mPages;
+	std::unordered_map<TextureData*, size_t>	mImages; // page of each packed image
+
+	std::string									mThemePath;
+	bool										mThemePathKnown;
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_ATLAS_H
@@ -3,8 +3,12 @@
 #include "math/Misc.h"
 #include "renderers/Renderer.h" 
 #include "resources/ResourceManager.h"
+#include "resources/SvgRasterCache.h"
+#include "resources/TextureAtlas.h"
+#include "resources/ThumbnailCache.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "Profiler.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <assert.h>
@@ -13,9 +17,11 @@
 #define DPI 96
 
 bool TextureData::OPTIMIZEVRAM = false;
+std::atomic<size_t> TextureData::sTotalUsage(0);
 
 TextureData::TextureData(bool tile) : mTile(tile), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
-									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mMaxSize(MaxSizeInfo()), mPackedSize(Vector2i(0,0)), mBaseSize(Vector2i(0, 0))
+									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mMaxSize(MaxSizeInfo()), mPackedSize(Vector2i(0,0)), mBaseSize(Vector2i(0, 0)), mUsage(0),
+									  mAtlasable(false), mAtlasTextureID(0), mTextureRect(0.0f, 0.0f, 1.0f, 1.0f)
 {
 	mIsExternalDataRGBA = false;
 }
@@ -37,11 +43,13 @@ void TextureData::initFromPath(const std::string& path)
 bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length)
 {
 	// If already initialised then don't read again
-	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA)
-		return true;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
+	}
 
-	// nsvgParse excepts a modifiable, null-terminated string
+	// nsvgParse expects a modifiable, null-terminated string
 	char* copy = (char*)malloc(length + 1);
 	assert(copy != NULL);
 	memcpy(copy, fileData, length);
@@ -55,6 +63,53 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 		return false;
 	}
 
+	// No path to key the bitmap with, it's not cached
+	bool ret = initSVGFromImage(svgImage, "");
+	nsvgDelete(svgImage);
+	return ret;
+}
+
+std::string TextureData::getSVGVariant()
+{
+	// Everything the rasterized size depends on
+	return std::to_string(mSourceWidth) + "x" + std::to_string(mSourceHeight) + "|" +
+		std::to_string(mMaxSize.x()) + "x" + std::to_string(mMaxSize.y()) + (mMaxSize.externalZoom() ? "|zoom" : "") +
+		(OPTIMIZEVRAM ? "|vram" : "");
+}
+
+bool TextureData::initSVGFromCache(const std::string& variant)
+{
+	// If already initialised then don't read again
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mDataRGBA)
+		return true;
+
+	ThumbnailInfo info;
+
+	unsigned char* dataRGBA = SvgRasterCache::getInstance()->getBitmap(mPath, variant, info);
+	if (dataRGBA == nullptr)
+		return false;
+
+	mSourceWidth = info.sourceSize.x();
+	mSourceHeight = info.sourceSize.y();
+	mWidth = info.width;
+	mHeight = info.height;
+	mBaseSize = info.baseSize;
+	mPackedSize = info.packedSize;
+
+	mDataRGBA = dataRGBA;
+	updateUsage();
+
+	return true;
+}
+
+bool TextureData::initSVGFromImage(NSVGimage* svgImage, const std::string& variant)
+{
+	// If already initialised then don't read again
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mDataRGBA)
+		return true;
+
 	if (svgImage->width == 0 || svgImage->height == 0)
 		return false;
 
@@ -105,15 +160,24 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 	else
 		mPackedSize = Vector2i(0, 0);
 	
-	unsigned char* dataRGBA = new unsigned char[mWidth * mHeight * 4];
-
-	NSVGrasterizer* rast = nsvgCreateRasterizer();
-	nsvgRasterize(rast, svgImage, 0, 0, mHeight / svgImage->height, dataRGBA, (int)mWidth, (int)mHeight, (int)mWidth * 4);
-	nsvgDeleteRasterizer(rast);
+	unsigned char* dataRGBA = SvgRasterCache::rasterize(svgImage, mHeight / svgImage->height, mWidth, mHeight);
 
 	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
 
 	mDataRGBA = dataRGBA;
+	updateUsage();
+
+	if (!variant.empty())
+	{
+		ThumbnailInfo info;
+		info.width = mWidth;
+		info.height = mHeight;
+		info.baseSize = mBaseSize;
+		info.packedSize = mPackedSize;
+		info.sourceSize = Vector2f(mSourceWidth, mSourceHeight);
+
+		SvgRasterCache::getInstance()->putBitmap(mPath, variant, mDataRGBA, info);
+	}
 
 	return true;
 }
@@ -141,6 +205,53 @@ bool TextureData::isRequiredTextureSizeOk()
 	return false;
 }
 
+Vector2i TextureData::getImageMaxSize()
+{
+	auto x = OPTIMIZEVRAM ? mMaxSize.x() : Renderer::getScreenWidth();
+	if (x > Renderer::getScreenWidth())
+		x = Renderer::getScreenWidth();
+
+	auto y = OPTIMIZEVRAM ? mMaxSize.y() : Renderer::getScreenHeight();
+	if (y > Renderer::getScreenHeight())
+		y = Renderer::getScreenHeight();
+
+	return Vector2i((int)x, (int)y);
+}
+
+std::string TextureData::getImageVariant()
+{
+	Vector2i maxSize = getImageMaxSize();
+	return std::to_string(maxSize.x()) + "x" + std::to_string(maxSize.y()) + (mMaxSize.externalZoom() ? "|zoom" : "");
+}
+
+bool TextureData::initImageFromCache()
+{
+	// Only gamelist media, the resources are in memory already
+	if (mPath.empty() || mPath[0] == ':' || !ThumbnailCache::isEnabled())
+		return false;
+
+	// If already initialised then don't read again
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
+	}
+
+	ThumbnailInfo info;
+
+	unsigned char* imageRGBA = ThumbnailCache::getInstance()->load(mPath, getImageVariant(), info);
+	if (imageRGBA == nullptr)
+		return false;
+
+	mBaseSize = info.baseSize;
+	mPackedSize = info.packedSize;
+	mSourceWidth = info.sourceSize.x();
+	mSourceHeight = info.sourceSize.y();
+	mScalable = false;
+
+	return initFromRGBAEx(imageRGBA, info.width, info.height);
+}
+
 bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t length)
 {
 	size_t width, height;
@@ -152,22 +263,28 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 			return true;
 	}
 	
+	Vector2i maxSize = getImageMaxSize();
 
-	auto x = OPTIMIZEVRAM ? mMaxSize.x() : Renderer::getScreenWidth();
-	if (x > Renderer::getScreenWidth())
-		x = Renderer::getScreenWidth();
-
-	auto y = OPTIMIZEVRAM ? mMaxSize.y() : Renderer::getScreenHeight();
-	if (y > Renderer::getScreenHeight())
-		y = Renderer::getScreenHeight();
-
-	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, x, y, mMaxSize.externalZoom(), mBaseSize, mPackedSize);
+	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, maxSize.x(), maxSize.y(), mMaxSize.externalZoom(), mBaseSize, mPackedSize);
 	if (imageRGBA == NULL)
 	{
 		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
 		return false;
 	}
 
+	// Next time, read it back already decoded and resized
+	if (!mPath.empty() && mPath[0] != ':' && ThumbnailCache::isEnabled())
+	{
+		ThumbnailInfo info;
+		info.width = width;
+		info.height = height;
+		info.baseSize = mBaseSize;
+		info.packedSize = mPackedSize;
+		info.sourceSize = Vector2f((float) width, (float) height);
+
+		ThumbnailCache::getInstance()->save(mPath, getImageVariant(), imageRGBA, info);
+	}
+
 	mSourceWidth = (float) width;
 	mSourceHeight = (float) height;
 	mScalable = false;
@@ -212,6 +329,7 @@ bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size
 	memcpy(mDataRGBA, dataRGBA, width * height * 4);
 	mWidth = width;
 	mHeight = height;
+	updateUsage();
 	return true;
 }
 
@@ -233,6 +351,7 @@ bool TextureData::initFromRGBAEx(unsigned char* dataRGBA, size_t width, size_t h
 	mDataRGBA = dataRGBA;
 	mWidth = width;
 	mHeight = height;
+	updateUsage();
 
 	return true;
 }
@@ -249,6 +368,7 @@ bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, si
 	mDataRGBA = dataRGBA;
 	mWidth = width;
 	mHeight = height;
+	updateUsage();
 
 	if (mTextureID != 0)
 		Renderer::updateTexture(mTextureID, Renderer::Texture::RGBA, -1, -1, mWidth, mHeight, mDataRGBA);
@@ -258,6 +378,8 @@ bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, si
 
 bool TextureData::load()
 {
+	PROFILE_SCOPE("TextureData::load");
+
 	bool retval = false;
 
 	// Need to load. See if there is a file
@@ -265,15 +387,29 @@ bool TextureData::load()
 	{
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 
-		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
 		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
 		{
 			mScalable = true; // ??? interest ?
-			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
+
+			// Theme reloads and evicted textures reuse the same bitmaps, then the same parsed files
+			std::string variant = getSVGVariant();
+			if (initSVGFromCache(variant))
+				retval = true;
+			else
+			{
+				std::shared_ptr<NSVGimage> svgImage = SvgRasterCache::getInstance()->getImage(mPath);
+				if (svgImage != nullptr)
+					retval = initSVGFromImage(svgImage.get(), variant);
+			}
 		}
+		else if (initImageFromCache())
+			retval = true;
 		else
+		{
+			const ResourceData& data = rm->getFileData(mPath);
 			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
+		}
 	}
 
 	
@@ -284,7 +420,7 @@ bool TextureData::load()
 bool TextureData::isLoaded()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA || (mTextureID != 0))
+	if (mDataRGBA || (mTextureID != 0) || (mAtlasTextureID != 0))
 		return true;
 
 	return false;
@@ -298,8 +434,14 @@ bool TextureData::uploadAndBind()
 	{
 		Renderer::bindTexture(mTextureID);
 	}
+	else if (mAtlasTextureID != 0)
+	{
+		Renderer::bindTexture(mAtlasTextureID);
+	}
 	else
 	{
+		PROFILE_SCOPE("TextureData::upload");
+
 		// Load it if necessary
 		if (!mDataRGBA)
 		{
@@ -309,6 +451,16 @@ bool TextureData::uploadAndBind()
 		if ((mWidth == 0) || (mHeight == 0) || (mDataRGBA == nullptr))
 			return false;
 
+		// Small static images share a texture with others
+		if (mAtlasable && !mTile && !mIsExternalDataRGBA && TextureAtlas::getInstance()->add(this, mDataRGBA, mWidth, mHeight, mAtlasTextureID, mTextureRect))
+		{
+			delete[] mDataRGBA;
+			mDataRGBA = nullptr;
+
+			Renderer::bindTexture(mAtlasTextureID);
+			return true;
+		}
+
 		mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, true, mTile, mWidth, mHeight, mDataRGBA);
 		if (mTextureID)
 		{
@@ -316,6 +468,9 @@ bool TextureData::uploadAndBind()
 				delete[] mDataRGBA;
 
 			mDataRGBA = nullptr;
+
+			// Creating it only binds it in the driver, the batched draws use the renderer's texture
+			Renderer::bindTexture(mTextureID);
 		}
 	}
 
@@ -329,6 +484,14 @@ void TextureData::releaseVRAM()
 	{
 		Renderer::destroyTexture(mTextureID);
 		mTextureID = 0;
+		updateUsage();
+	}
+	else if (mAtlasTextureID != 0)
+	{
+		TextureAtlas::getInstance()->remove(this);
+		mAtlasTextureID = 0;
+		mTextureRect = Vector4f(0.0f, 0.0f, 1.0f, 1.0f);
+		updateUsage();
 	}
 }
 
@@ -340,6 +503,7 @@ void TextureData::releaseRAM()
 		delete[] mDataRGBA;
 
 	mDataRGBA = 0;
+	updateUsage();
 }
 
 size_t TextureData::width()
@@ -372,10 +536,12 @@ float TextureData::sourceHeight()
 
 void TextureData::setTemporarySize(float width, float height)
 {
+	std::unique_lock<std::mutex> lock(mMutex);
 	mWidth = width;
 	mHeight = height;
 	mSourceWidth = width;
 	mSourceHeight = height;
+	updateUsage();
 }
 
 void TextureData::setSourceSize(float width, float height)
@@ -396,8 +562,19 @@ void TextureData::setSourceSize(float width, float height)
 
 size_t TextureData::getVRAMUsage()
 {
-	if ((mTextureID != 0) || (mDataRGBA != nullptr))
+	if ((mTextureID != 0) || (mAtlasTextureID != 0) || (mDataRGBA != nullptr))
 		return mWidth * mHeight * 4;
 	else
 		return 0;
 }
+
+void TextureData::updateUsage()
+{
+	size_t usage = ((mTextureID != 0) || (mAtlasTextureID != 0) || (mDataRGBA != nullptr)) ? mWidth * mHeight * 4 : 0;
+	if (usage == mUsage)
+		return;
+
+	sTotalUsage += usage;
+	sTotalUsage -= mUsage;
+	mUsage = usage;
+}
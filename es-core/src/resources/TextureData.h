@@ -2,14 +2,17 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include <atomic>
 #include <mutex>
 #include <string>
 
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
+#include "math/Vector4f.h"
 #include "resources/TextureResource.h"
 
 // class TextureResource;
+struct NSVGimage;
 
 class TextureData
 {
@@ -48,6 +51,11 @@ public:
 
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
+	// Get the amount of VRAM this texture will use once loaded, without loading it
+	size_t getEstimatedSize() { return mWidth * mHeight * 4; }
+
+	// Bytes used by all the loaded textures, kept up to date as they are loaded and released
+	static size_t getTotalUsage() { return sTotalUsage.load(); }
 
 	size_t width();
 	size_t height();
@@ -59,6 +67,11 @@ public:
 
 	bool tiled() { return mTile; }
 
+	// Allows uploadAndBind to pack the texture in the TextureAtlas
+	void setAtlasable(bool atlasable) { mAtlasable = atlasable; }
+	// Part of the bound texture used by this one (x, y, w, h in texture coordinates), all of it unless it's packed
+	Vector4f getTextureRect() { std::unique_lock<std::mutex> lock(mMutex); return mTextureRect; }
+
 	bool isRequiredTextureSizeOk();
 
 	std::string		mPath;
@@ -69,7 +82,26 @@ public:
 	}
 
 private:
+	// Loads the image from the thumbnail cache, returns false if it's not there
+	bool initImageFromCache();
+	// Size the images are decoded at
+	Vector2i getImageMaxSize();
+	// Thumbnail cache variant of the images and of the SVGs
+	std::string getImageVariant();
+	std::string getSVGVariant();
+
+	// Loads the SVG bitmap from the SvgRasterCache, returns false if it's not there
+	bool initSVGFromCache(const std::string& variant);
+	// Rasterizes a parsed SVG, and caches the bitmap if variant is not empty
+	bool initSVGFromImage(NSVGimage* svgImage, const std::string& variant);
+
+	// Accounts the change of getVRAMUsage() in sTotalUsage, mMutex must be held
+	void updateUsage();
+
+	static std::atomic<size_t> sTotalUsage;
+
 	std::mutex		mMutex;
+	size_t			mUsage;
 	bool			mTile;
 	unsigned char*	mDataRGBA;
 	size_t			mWidth;
@@ -84,6 +116,10 @@ private:
 	MaxSizeInfo		mMaxSize;
 
 	bool			mIsExternalDataRGBA;
+
+	bool			mAtlasable;
+	unsigned int	mAtlasTextureID; // page texture when packed in the TextureAtlas, mTextureID stays 0
+	Vector4f		mTextureRect;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
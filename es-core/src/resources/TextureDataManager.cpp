@@ -5,10 +5,17 @@
 #include "Settings.h"
 #include "utils/StringUtil.h"
 #include "utils/FileSystemUtil.h"
+#include "Window.h"
 #include <SDL_timer.h>
 
 TextureDataManager::TextureDataManager()
 {
+	for (int i = 0; i < POOL_COUNT; i++)
+	{
+		mPools[i].head = nullptr;
+		mPools[i].tail = nullptr;
+	}
+
 	unsigned char data[5 * 5 * 4];
 	mBlank = std::shared_ptr<TextureData>(new TextureData(false));
 	for (int i = 0; i < (5 * 5); ++i)
@@ -26,58 +33,133 @@ TextureDataManager::TextureDataManager()
 TextureDataManager::~TextureDataManager()
 {
 	delete mLoader;
+
+	for (auto it = mTextureLookup.cbegin(); it != mTextureLookup.cend(); ++it)
+		delete it->second;
+}
+
+void TextureDataManager::link(TextureEntry* entry)
+{
+	TexturePool& pool = mPools[entry->pool];
+
+	entry->prev = nullptr;
+	entry->next = pool.head;
+
+	if (pool.head != nullptr)
+		pool.head->prev = entry;
+	else
+		pool.tail = entry;
+
+	pool.head = entry;
+	entry->linked = true;
+}
+
+void TextureDataManager::unlink(TextureEntry* entry)
+{
+	if (!entry->linked)
+		return;
+
+	TexturePool& pool = mPools[entry->pool];
+
+	if (entry->prev != nullptr)
+		entry->prev->next = entry->next;
+	else
+		pool.head = entry->next;
+
+	if (entry->next != nullptr)
+		entry->next->prev = entry->prev;
+	else
+		pool.tail = entry->prev;
+
+	entry->prev = nullptr;
+	entry->next = nullptr;
+	entry->linked = false;
+}
+
+void TextureDataManager::touch(TextureEntry* entry)
+{
+	// Move it to the top of its pool
+	if (entry->linked && mPools[entry->pool].head == entry)
+		return;
+
+	unlink(entry);
+	link(entry);
+}
+
+void TextureDataManager::erase(const TextureResource* key)
+{
+	auto it = mTextureLookup.find(key);
+	if (it == mTextureLookup.cend())
+		return;
+
+	TextureEntry* entry = it->second;
+	unlink(entry);
+
+	mDataLookup.erase(entry->data.get());
+	mTextureLookup.erase(it);
+
+	delete entry;
 }
 
 void TextureDataManager::onTextureLoaded(std::shared_ptr<TextureData> tex)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	for (auto it = mTextureLookup.cbegin(); it != mTextureLookup.cend(); it++)
-	{
-		std::shared_ptr<TextureData> texture = *(*it).second;		
-		if (texture == tex)
-		{
-			const TextureResource* pResource = it->first;
-			((TextureResource*)pResource)->onTextureLoaded(tex);
-		}
-	}
-}
+	auto it = mDataLookup.find(tex.get());
+	if (it == mDataLookup.cend())
+		return;
+
+	// An eviction may have dropped it from its pool while it was decoding, it uses memory again
+	TextureEntry* entry = it->second;
+	if (!entry->linked)
+		link(entry);
 
+	((TextureResource*)entry->key)->onTextureLoaded(tex);
+}
 
 std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key, bool tiled)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	// Find the entry in the list
-	auto it = mTextureLookup.find(key);
-	if (it != mTextureLookup.cend())
-	{
-		// Remove the list entry
-		mTextures.erase((*it).second);
-		// And the lookup
-		mTextureLookup.erase(it);
-	}
+	erase(key);
+
+	TextureEntry* entry = new TextureEntry();
+	entry->key = key;
+	entry->data = std::make_shared<TextureData>(tiled);
+	entry->pool = POOL_MEDIA;
+	entry->linked = false;
+	entry->prev = nullptr;
+	entry->next = nullptr;
 
-	std::shared_ptr<TextureData> data = std::make_shared<TextureData>(tiled);
-	mTextures.push_front(data);
-	mTextureLookup[key] = mTextures.cbegin();
+	link(entry);
+	mTextureLookup[key] = entry;
+	mDataLookup[entry->data.get()] = entry;
 
-	return data;
+	return entry->data;
 }
 
 void TextureDataManager::remove(const TextureResource* key)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	erase(key);
+}
+
+void TextureDataManager::pin(const TextureResource* key)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	// Find the entry in the list
 	auto it = mTextureLookup.find(key);
-	if (it != mTextureLookup.cend())
-	{
-		// Remove the list entry
-		mTextures.erase((*it).second);
-		// And the lookup
-		mTextureLookup.erase(it);
-	}
+	if (it == mTextureLookup.cend() || it->second->pool == POOL_PINNED)
+		return;
+
+	TextureEntry* entry = it->second;
+	bool linked = entry->linked;
+
+	unlink(entry);
+	entry->pool = POOL_PINNED;
+
+	if (linked)
+		link(entry);
 }
 
 void TextureDataManager::cancelAsync(const TextureResource* key)
@@ -86,30 +168,29 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
-		mLoader->remove(*(*it).second);
+		mLoader->remove(it->second->data);
+}
+
+void TextureDataManager::setLoadHint(const TextureResource* key, TextureLoadPriority priority, const TextureLoadToken* token)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		mLoader->setHint(it->second->data, priority, token);
 }
 
 std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, bool enableLoading)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	// If it's in the cache then we want to remove it from it's current location and
-	// move it to the top
+	// If it's in the cache then we want to move it to the top
 	std::shared_ptr<TextureData> tex;
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
-		tex = *(*it).second;
-
-		if (mTextures.cbegin() != (*it).second)
-		{
-			// Remove the list entry
-			mTextures.erase((*it).second);
-			// Put it at the top
-			mTextures.push_front(tex);
-			// Store it back in the lookup
-			mTextureLookup[key] = mTextures.cbegin();
-		}
+		touch(it->second);
+		tex = it->second->data;
 
 		// Make sure it's loaded or queued for loading
 		if (enableLoading && !tex->isLoaded()) // FCATMP
@@ -121,7 +202,7 @@ std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key,
 	return tex;
 }
 
-bool TextureDataManager::bind(const TextureResource* key)
+bool TextureDataManager::bind(const TextureResource* key, Vector4f& textureRect)
 {
 	std::shared_ptr<TextureData> tex = get(key);
 	bool bound = false;
@@ -129,6 +210,8 @@ bool TextureDataManager::bind(const TextureResource* key)
 		bound = tex->uploadAndBind();
 	if (!bound)
 		mBlank->uploadAndBind();
+
+	textureRect = bound ? tex->getTextureRect() : Vector4f(0.0f, 0.0f, 1.0f, 1.0f);
 	return bound;
 }
 
@@ -137,19 +220,8 @@ size_t TextureDataManager::getTotalSize()
 	std::unique_lock<std::mutex> lock(mMutex);
 
 	size_t total = 0;
-	for (auto tex : mTextures)
-		total += tex->width() * tex->height() * 4;
-
-	return total;
-}
-
-size_t TextureDataManager::getCommittedSize()
-{
-	std::unique_lock<std::mutex> lock(mMutex);
-
-	size_t total = 0;
-	for (auto tex : mTextures)
-		total += tex->getVRAMUsage();
+	for (auto it = mTextureLookup.cbegin(); it != mTextureLookup.cend(); ++it)
+		total += it->second->data->width() * it->second->data->height() * 4;
 
 	return total;
 }
@@ -159,14 +231,9 @@ size_t TextureDataManager::getQueueSize()
 	return mLoader->getQueueSize();
 }
 
-bool compareTextures(const std::shared_ptr<TextureData>& first, const std::shared_ptr<TextureData>& second)
-{	
-	bool isResource = first->mPath.rfind(":/") == 0;
-	bool secondIsResource = second->mPath.rfind(":/") == 0;
-	if (isResource && !secondIsResource)
-		return true;
-
-	return false;
+TextureLoaderStats TextureDataManager::getLoaderStats()
+{
+	return mLoader->getStats();
 }
 
 void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
@@ -185,44 +252,38 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 
 	// Not loaded. Make sure there is room
-	size_t size = TextureResource::getTotalMemUsage();
 	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
 
-	if (size >= max_texture)
+	if (TextureData::getTotalUsage() + mLoader->getQueueSize() >= max_texture)
 	{
 		std::unique_lock<std::mutex> lock(mMutex);
 
-		std::list<std::shared_ptr<TextureData>> orderedTextures(mTextures);
-		orderedTextures.sort(compareTextures);
-
-		for (auto it = orderedTextures.crbegin(); it != orderedTextures.crend(); ++it)
+		// Least recently used first, gamelist media before pinned textures.
+		// Whatever is released leaves its pool until it is used again, so it is never walked twice.
+		for (int pool = POOL_MEDIA; pool < POOL_COUNT; pool++)
 		{
-			if (size < max_texture)
-				break;
-
-			if ((*it) == tex)
-				continue;
+			TextureEntry* entry = mPools[pool].tail;
 
-			bool changed = false;
-
-			if ((*it)->isLoaded())
+			while (entry != nullptr && TextureData::getTotalUsage() + mLoader->getQueueSize() >= max_texture)
 			{
-				(*it)->releaseVRAM();
-				(*it)->releaseRAM();
+				TextureEntry* prev = entry->prev;
 
-				changed = true;
-			}
+				if (entry->data != tex)
+				{
+					if (entry->data->isLoaded())
+					{
+						entry->data->releaseVRAM();
+						entry->data->releaseRAM();
+					}
 
-			// It may be already in the loader queue. In this case it wouldn't have been using
-			// any VRAM yet but it will be. Remove it from the loader queue
-			if (mLoader->remove(*it))
-				changed = true;
+					// It may be already in the loader queue. In this case it wouldn't have been using
+					// any VRAM yet but it will be. Remove it from the loader queue
+					mLoader->remove(entry->data);
 
-			if (changed)
-			{
-				lock.unlock();
-				size = TextureResource::getTotalMemUsage();
-				lock.lock();
+					unlink(entry);
+				}
+
+				entry = prev;
 			}
 		}
 	}
@@ -238,16 +299,14 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mActiveTasks(0), mQueueSize(0), mDecoded(0), mDropped(0), mDecodeTime(0), mVisibleLatency(0)
 {
 	mManager = mgr;
 
-	int num_threads = std::thread::hardware_concurrency() / 2;
-	if (num_threads == 0)
-		num_threads = 1;
-
-	for (size_t i = 0; i < num_threads; i++)
-		mThreads.push_back(std::thread(&TextureLoader::threadProc, this));
+	// Decode on half of the shared workers at most, the rest stays available for other tasks
+	mMaxTasks = (int)Utils::TaskScheduler::getInstance()->getWorkerCount() / 2;
+	if (mMaxTasks == 0)
+		mMaxTasks = 1;
 }
 
 TextureLoader::~TextureLoader()
@@ -255,46 +314,75 @@ TextureLoader::~TextureLoader()
 	// Just abort any waiting texture
 	clearQueue();
 
-	// Exit the thread
-	mExit = true;
-	mEvent.notify_all();
-	
-	for (std::thread& t : mThreads)
-		t.join();	
+	// Let the textures being decoded finish
+	mTasks.wait();
 }
 
-void TextureLoader::threadProc()
+void TextureLoader::dequeue(Queue::iterator it)
 {
+	mQueueSize -= it->size;
+	mTextureDataLookup.erase(it->data.get());
+	mTextureDataQ[it->priority].erase(it);
+}
+
+void TextureLoader::processQueue()
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
 	while (true)
 	{
-		// Wait for an event to say there is something in the queue
-		std::unique_lock<std::mutex> lock(mLoaderLock);
-		mEvent.wait(lock, [this]() { return mExit || !mTextureDataQ.empty(); });
+		// Most urgent first, newest requests first within a priority
+		int priority = 0;
+		while (priority < TEXTURE_PRIORITY_COUNT && mTextureDataQ[priority].empty())
+			priority++;
 
-		if (mExit)
+		if (priority == TEXTURE_PRIORITY_COUNT)
 			break;
 
-		if (!mTextureDataQ.empty())
+		QueuedTexture texture = mTextureDataQ[priority].front();
+		dequeue(mTextureDataQ[priority].begin());
+
+		// The view moved on since it asked for it
+		if (isStale(texture))
 		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
+			mDropped++;
+			continue;
+		}
 
-			mProcessingTextureDataQ.push_back(textureData);
+		std::shared_ptr<TextureData> textureData = texture.data;
+		mProcessingTextureData.insert(textureData.get());
 
-			lock.unlock();
+		lock.unlock();
 
-			if (textureData && !textureData->isLoaded())
-			{
-				textureData->load();
-				mManager->onTextureLoaded(textureData);
+		bool decoded = false;
+		Clock::time_point start = Clock::now();
 
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);
+		if (textureData && !textureData->isLoaded())
+		{
+			textureData->load();
+			mManager->onTextureLoaded(textureData);
+			decoded = true;
 
-				std::this_thread::yield();
-			}
+			// the image can be shown now
+			Window::invalidate();
+		}
+
+		Clock::time_point end = Clock::now();
+
+		lock.lock();
+		mProcessingTextureData.erase(textureData.get());
+
+		if (decoded)
+		{
+			mDecoded++;
+			mDecodeTime += (std::chrono::duration<float, std::milli>(end - start).count() - mDecodeTime) * 0.1f;
+
+			if (priority == TEXTURE_PRIORITY_VISIBLE)
+				mVisibleLatency += (std::chrono::duration<float, std::milli>(end - texture.requested).count() - mVisibleLatency) * 0.1f;
 		}
 	}
+
+	mActiveTasks--;
 }
 
 void TextureLoader::load(std::shared_ptr<TextureData> textureData)
@@ -306,17 +394,59 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 		return;
 
 	// If is is currently loading, don't add again
-	if (std::find(mProcessingTextureDataQ.cbegin(), mProcessingTextureDataQ.cend(), textureData) != mProcessingTextureDataQ.cend())
+	if (mProcessingTextureData.find(textureData.get()) != mProcessingTextureData.cend())
 		return;
 
-	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	auto tx = mTextureDataLookup.find(textureData.get());
+	if (tx != mTextureDataLookup.cend())
+	{
+		// Already queued, put it back on the start of its queue : the newly requested textures load first
+		Queue& queue = mTextureDataQ[tx->second->priority];
+		queue.splice(queue.begin(), queue, tx->second);
+		return;
+	}
+
+	QueuedTexture texture;
+	texture.data = textureData;
+	texture.priority = TEXTURE_PRIORITY_VISIBLE;
+	texture.generation = 0;
+	texture.requested = Clock::now();
 
-	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
-	mEvent.notify_one();
+	// Gets the amount of video memory that will be used once it is loaded.
+	// Asynchronous textures know their size before loading, width() would load the others
+	texture.size = textureData->getEstimatedSize();
+
+	Queue& queue = mTextureDataQ[texture.priority];
+	queue.push_front(texture);
+	mTextureDataLookup[textureData.get()] = queue.begin();
+	mQueueSize += texture.size;
+
+	// Start another decoding task unless enough of them are already draining the queue
+	if (mActiveTasks < mMaxTasks)
+	{
+		mActiveTasks++;
+		mTasks.run([this] { processQueue(); });
+	}
+}
+
+void TextureLoader::setHint(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority, const TextureLoadToken* token)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	auto tx = mTextureDataLookup.find(textureData.get());
+	if (tx == mTextureDataLookup.cend())
+		return;
+
+	Queue::iterator it = tx->second;
+
+	it->token = (token != nullptr ? token->mGeneration : nullptr);
+	it->generation = (token != nullptr ? token->current() : 0);
+
+	if (it->priority != priority)
+	{
+		mTextureDataQ[priority].splice(mTextureDataQ[priority].begin(), mTextureDataQ[it->priority], it);
+		it->priority = priority;
+	}
 }
 
 bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
@@ -324,10 +454,10 @@ bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
+	auto tx = mTextureDataLookup.find(textureData.get());
+	if (tx != mTextureDataLookup.cend())
 	{
-		mTextureDataQ.erase(tx);
+		dequeue(tx->second);
 		return true;
 	}
 
@@ -340,11 +470,24 @@ size_t TextureLoader::getQueueSize()
 
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
-	size_t mem = 0;
-	for (auto tex : mTextureDataQ)	
-		mem += tex->width() * tex->height() * 4;
+	return mQueueSize;
+}
 
-	return mem;
+TextureLoaderStats TextureLoader::getStats()
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	TextureLoaderStats stats;
+
+	for (int i = 0; i < TEXTURE_PRIORITY_COUNT; i++)
+		stats.queued[i] = (int)mTextureDataQ[i].size();
+
+	stats.decoded = mDecoded;
+	stats.dropped = mDropped;
+	stats.decodeTime = mDecodeTime;
+	stats.visibleLatency = mVisibleLatency;
+
+	return stats;
 }
 
 void TextureLoader::clearQueue()
@@ -352,11 +495,15 @@ void TextureLoader::clearQueue()
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Just abort any waiting texture
-	mTextureDataQ.clear();
+	for (int i = 0; i < TEXTURE_PRIORITY_COUNT; i++)
+		mTextureDataQ[i].clear();
+
+	mTextureDataLookup.clear();
+	mQueueSize = 0;
 }
 
 void TextureDataManager::clearQueue()
 {
 	if (mLoader != nullptr)
 		mLoader->clearQueue();
-}
\ No newline at end of file
+}
@@ -2,13 +2,16 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
-#include <condition_variable>
+#include "math/Vector4f.h"
+#include "utils/TaskScheduler.h"
+#include <atomic>
+#include <chrono>
 #include <list>
-#include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <thread>
 #ifdef _RPI_
 #include <algorithm>
 #endif
@@ -17,30 +20,91 @@ class TextureData;
 class TextureResource;
 class TextureDataManager;
 
+// Order in which the queued textures are decoded
+enum TextureLoadPriority
+{
+	TEXTURE_PRIORITY_VISIBLE = 0,	// on screen
+	TEXTURE_PRIORITY_NEXT_PAGE = 1,	// shown by the next scroll step
+	TEXTURE_PRIORITY_PREFETCH = 2,	// may be shown later
+
+	TEXTURE_PRIORITY_COUNT = 3
+};
+
+// Generation token of a view. A queued texture hinted under an older generation of its token is stale,
+// it is dropped instead of decoded : the view starts a new generation each time it shows other entries.
+class TextureLoadToken
+{
+public:
+	TextureLoadToken() : mGeneration(std::make_shared<std::atomic<int>>(0)) { }
+
+	int next() { return ++(*mGeneration); }
+	int current() const { return mGeneration->load(); }
+
+private:
+	friend class TextureLoader;
+	std::shared_ptr<std::atomic<int>> mGeneration;
+};
+
+struct TextureLoaderStats
+{
+	int		queued[TEXTURE_PRIORITY_COUNT];
+	int		decoded;
+	int		dropped;			// stale textures removed from the queue without decoding them
+	float	decodeTime;			// ms, moving average
+	float	visibleLatency;		// ms from the request to the end of the decode, moving average of the visible textures
+};
+
 class TextureLoader
 {
 public:
 	TextureLoader(TextureDataManager* mgr);
 	~TextureLoader();
 
+	// New textures are queued as visible, a texture already queued keeps its hint
 	void load(std::shared_ptr<TextureData> textureData);
 	bool remove(std::shared_ptr<TextureData> textureData);
 	void clearQueue();
 
+	// Moves a queued texture to the given priority, token is the view's generation token (nullptr : never stale)
+	void setHint(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority, const TextureLoadToken* token);
+
 	size_t getQueueSize();
+	TextureLoaderStats getStats();
 
 private:	
-	void threadProc();
+	typedef std::chrono::steady_clock Clock;
+
+	struct QueuedTexture
+	{
+		std::shared_ptr<TextureData>		data;
+		size_t								size; // bytes it will use once loaded
+		int									priority;
+		std::shared_ptr<std::atomic<int>>	token;
+		int									generation;
+		Clock::time_point					requested;
+	};
 
-	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
+	typedef std::list<QueuedTexture> Queue;
 
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureDataLookup;
+	void processQueue();
+	void dequeue(Queue::iterator it);
+	bool isStale(const QueuedTexture& texture) { return texture.token != nullptr && texture.token->load() != texture.generation; }
+
+	std::unordered_set<TextureData*>									mProcessingTextureData;
+
+	Queue 																mTextureDataQ[TEXTURE_PRIORITY_COUNT];
+	std::unordered_map<TextureData*, Queue::iterator > 					mTextureDataLookup;
+	size_t																mQueueSize; // bytes the queued textures will use once loaded
+
+	int							mDecoded;
+	int							mDropped;
+	float						mDecodeTime;
+	float						mVisibleLatency;
 
-	std::vector<std::thread>	mThreads;	
 	std::mutex					mLoaderLock;
-	std::condition_variable		mEvent;
-	bool 						mExit;
+	Utils::TaskGroup			mTasks;
+	int							mActiveTasks;
+	int							mMaxTasks;
 
 	TextureDataManager*			mManager;
 };
@@ -59,6 +123,11 @@ private:
 // to releaseRAM() which frees the memory buffer if the texture can be reloaded from
 // disk if needed again
 //
+// The textures are kept in two LRU lists linked through their entries, the pinned pool
+// (textures loaded with forceLoad) is only evicted once the gamelist media pool is empty.
+// Touching, evicting and dequeuing a texture are constant time, the memory used by the
+// textures is a running counter (see TextureData::getTotalUsage).
+//
 class TextureDataManager
 {
 public:
@@ -72,17 +141,19 @@ public:
 	// will be deleted when the other thread has finished with it
 	void remove(const TextureResource* key);
 	void cancelAsync(const TextureResource* key);
+	void setLoadHint(const TextureResource* key, TextureLoadPriority priority, const TextureLoadToken* token);
 
 	std::shared_ptr<TextureData> get(const TextureResource* key, bool enableLoading = true);
-	bool bind(const TextureResource* key);
+	// Moves the texture to the pinned pool, evicted after all the gamelist media
+	void pin(const TextureResource* key);
+	bool bind(const TextureResource* key, Vector4f& textureRect);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
 	size_t	getTotalSize();
-	// Get the total size of all committed textures (in VRAM) in bytes
-	size_t	getCommittedSize();
 	// Get the total size of all load-pending textures in the queue - these will
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
+	TextureLoaderStats getLoaderStats();
 	// Load a texture, freeing resources as necessary to make space
 	void load(std::shared_ptr<TextureData> tex, bool block = false);
 
@@ -91,12 +162,41 @@ public:
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
 
 private:
+	enum Pool
+	{
+		POOL_MEDIA = 0,
+		POOL_PINNED = 1,
+		POOL_COUNT = 2
+	};
+
+	struct TextureEntry
+	{
+		const TextureResource*			key;
+		std::shared_ptr<TextureData>	data;
+		int								pool;
+		bool							linked;
+		TextureEntry*					prev;
+		TextureEntry*					next;
+	};
+
+	struct TexturePool
+	{
+		TextureEntry*	head; // most recently used
+		TextureEntry*	tail;
+	};
+
+	void link(TextureEntry* entry);
+	void unlink(TextureEntry* entry);
+	void touch(TextureEntry* entry);
+	void erase(const TextureResource* key);
+
 	std::mutex					mMutex;
 
-	std::list<std::shared_ptr<TextureData> >												mTextures;
-	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
-	std::shared_ptr<TextureData>															mBlank;
-	TextureLoader*																			mLoader;
+	TexturePool																	mPools[POOL_COUNT];
+	std::unordered_map<const TextureResource*, TextureEntry*>					mTextureLookup;
+	std::unordered_map<TextureData*, TextureEntry*>								mDataLookup;
+	std::shared_ptr<TextureData>												mBlank;
+	TextureLoader*																mLoader;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
@@ -1,6 +1,7 @@
 #include "resources/TextureResource.h"
 
 #include "utils/FileSystemUtil.h"
+#include "resources/TextureAtlas.h"
 #include "resources/TextureData.h"
 #include "ImageIO.h"
 #include "Settings.h"
@@ -11,7 +12,7 @@ TextureDataManager		TextureResource::sTextureDataManager;
 std::map< TextureResource::TextureKeyType, std::weak_ptr<TextureResource>> TextureResource::sTextureMap;
 std::set<TextureResource*> 	TextureResource::sAllTextures;
 
-TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic, bool allowAsync, MaxSizeInfo maxSize) : mTextureData(nullptr), mForceLoad(false)
+TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic, bool allowAsync, MaxSizeInfo maxSize) : mTextureData(nullptr), mForceLoad(false), mTextureRect(0.0f, 0.0f, 1.0f, 1.0f)
 {
 #if _DEBUG
 	mPath = path;
@@ -27,6 +28,7 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool dynami
 		{			
 			data = sTextureDataManager.add(this, tile);
 			data->setMaxSize(maxSize);
+			data->setAtlasable(!tile && TextureAtlas::getInstance()->isStaticImage(path));
 			data->initFromPath(path);
 
 			bool async = false;
@@ -62,6 +64,7 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool dynami
 			
 			data = mTextureData;
 			data->setMaxSize(maxSize);
+			data->setAtlasable(!tile && TextureAtlas::getInstance()->isStaticImage(path));
 			data->initFromPath(path);
 			// Load it so we can read the width/height
 			data->load();
@@ -158,15 +161,25 @@ bool TextureResource::bind()
 {
 	if (mTextureData != nullptr)
 	{
+		// Released when the atlas was reset
+		if (!mTextureData->isLoaded())
+			mTextureData->load();
+
 		mTextureData->uploadAndBind();
+		mTextureRect = mTextureData->getTextureRect();
 		return true;
 	}
 	else
 	{
-		return sTextureDataManager.bind(this);
+		return sTextureDataManager.bind(this, mTextureRect);
 	}
 }
 
+const Vector4f& TextureResource::getTextureRect() const
+{
+	return mTextureRect;
+}
+
 void TextureResource::resetCache()
 {
 	sTextureDataManager.clearQueue();
@@ -178,6 +191,12 @@ void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
 		sTextureDataManager.cancelAsync(texture.get());
 }
 
+void TextureResource::setLoadHint(std::shared_ptr<TextureResource> texture, TextureLoadPriority priority, const TextureLoadToken& token)
+{
+	if (texture != nullptr && texture->mTextureData == nullptr)
+		sTextureDataManager.setLoadHint(texture.get(), priority, &token);
+}
+
 std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool forceLoad, bool dynamic, bool asReloadable, MaxSizeInfo maxSize)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
@@ -242,6 +261,7 @@ std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, b
 	if (forceLoad)
 	{
 		tex->mForceLoad = forceLoad;
+		sTextureDataManager.pin(tex.get());
 		if (data != nullptr && !data->isLoaded())
 			data->load();
 	}
@@ -288,15 +308,8 @@ bool TextureResource::isLoaded() const
 
 size_t TextureResource::getTotalMemUsage()
 {
-	size_t total = 0;
-	// Count up all textures that manage their own texture data
-	for (auto tex : sAllTextures)
-	{
-		if (tex->mTextureData != nullptr)
-			total += tex->mTextureData->getVRAMUsage();
-	}
-	// Now get the committed memory from the manager
-	total += sTextureDataManager.getCommittedSize();
+	// All the loaded textures, managed or not
+	size_t total = TextureData::getTotalUsage();
 	// And the size of the loading queue
 	total += sTextureDataManager.getQueueSize();
 	return total;
@@ -316,6 +329,11 @@ size_t TextureResource::getTotalTextureSize()
 	return total;
 }
 
+TextureLoaderStats TextureResource::getLoaderStats()
+{
+	return sTextureDataManager.getLoaderStats();
+}
+
 bool TextureResource::unload()
 {
 	// Release the texture's resources
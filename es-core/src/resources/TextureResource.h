@@ -4,8 +4,10 @@
 
 #include "math/Vector2i.h"
 #include "math/Vector2f.h"
+#include "math/Vector4f.h"
 #include "resources/ResourceManager.h"
 #include "resources/TextureDataManager.h"
+#include <map>
 #include <set>
 #include <string>
 
@@ -53,6 +55,8 @@ protected:
 public:
 	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool forceLoad = false, bool dynamic = true, bool asReloadable = true, MaxSizeInfo maxSize = MaxSizeInfo());
 	static void cancelAsync(std::shared_ptr<TextureResource> texture);
+	// Tells the loader how urgent a texture waiting to be decoded is, see TextureLoadToken
+	static void setLoadHint(std::shared_ptr<TextureResource> texture, TextureLoadPriority priority, const TextureLoadToken& token);
 
 	void initFromPixels(const unsigned char* dataRGBA, size_t width, size_t height);
 	void initFromExternalPixels(unsigned char* dataRGBA, size_t width, size_t height);
@@ -69,9 +73,13 @@ public:
 
 	const Vector2i getSize() const;
 	bool bind();
+	// Part of the bound texture to draw (x, y, w, h in texture coordinates), set by bind(). Small static images
+	// are packed in a TextureAtlas, their texture coordinates must be mapped to it.
+	const Vector4f& getTextureRect() const;
 
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by textures (in bytes)
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
+	static TextureLoaderStats getLoaderStats();
 	static void resetCache();
 
 public:
@@ -91,6 +99,7 @@ private:
 	Vector2i					mSize;
 	Vector2f					mSourceSize;
 	bool							mForceLoad;
+	Vector4f					mTextureRect;
 
 	typedef std::pair<std::string, bool> TextureKeyType;
 	static std::map< TextureKeyType, std::weak_ptr<TextureResource> > sTextureMap; // map of textures, used to prevent duplicate textures
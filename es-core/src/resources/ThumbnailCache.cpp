@@ -0,0 +1,267 @@
+#include "resources/ThumbnailCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "PersistenceManager.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#define THUMBNAIL_CACHE_MAGIC		"ESTC"
+#define THUMBNAIL_CACHE_VERSION		2
+#define THUMBNAIL_CACHE_EXTENSION	".rgba"
+
+// Temporary files older than this are left over from an interrupted write
+#define THUMBNAIL_CACHE_TMP_MAX_AGE	60
+
+// Bigger images are decoded each time, caching them would flush the cache for little gain
+#define THUMBNAIL_CACHE_MAX_ENTRY	(2 * 1024 * 1024)
+
+namespace
+{
+	struct ThumbnailHeader
+	{
+		char		magic[4];
+		uint32_t	version;
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	baseWidth;
+		uint32_t	baseHeight;
+		uint32_t	packedWidth;
+		uint32_t	packedHeight;
+		float		sourceWidth;
+		float		sourceHeight;
+		uint32_t	keyLength;		// the key follows the header, then the pixels
+	};
+
+	uint64_t fnv1a(const std::string& value)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (unsigned char c : value)
+		{
+			hash ^= c;
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+}
+
+ThumbnailCache* ThumbnailCache::getInstance()
+{
+	// Never destroyed, textures may still be decoding while static objects are destroyed
+	static ThumbnailCache* sInstance = new ThumbnailCache();
+	return sInstance;
+}
+
+ThumbnailCache::ThumbnailCache() : mTotalSize(-1), mCollecting(false)
+{
+}
+
+bool ThumbnailCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("ThumbnailCache");
+}
+
+std::string ThumbnailCache::getCachePath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/thumbnails";
+}
+
+std::string ThumbnailCache::getKey(const std::string& path, long long mtime, const std::string& variant)
+{
+	return path + "|" + std::to_string(mtime) + "|" + variant;
+}
+
+std::string ThumbnailCache::getEntryPath(const std::string& key)
+{
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long) fnv1a(key));
+
+	return getCachePath() + "/" + name + THUMBNAIL_CACHE_EXTENSION;
+}
+
+unsigned char* ThumbnailCache::load(const std::string& path, const std::string& variant, ThumbnailInfo& info)
+{
+	long long mtime = Utils::FileSystem::getModificationTime(path);
+	if (mtime == 0)
+		return nullptr;
+
+	std::string key = getKey(path, mtime, variant);
+	std::string entryPath = getEntryPath(key);
+
+	FILE* file = fopen(entryPath.c_str(), "rb");
+	if (file == nullptr)
+		return nullptr;
+
+	unsigned char* data = nullptr;
+
+	ThumbnailHeader header;
+	if (fread(&header, sizeof(header), 1, file) == 1 &&
+		memcmp(header.magic, THUMBNAIL_CACHE_MAGIC, 4) == 0 &&
+		header.version == THUMBNAIL_CACHE_VERSION &&
+		header.keyLength == key.size() &&
+		(size_t)header.width * header.height * 4 <= THUMBNAIL_CACHE_MAX_ENTRY)
+	{
+		// The file name is a hash, make sure the entry is really this one
+		std::string entryKey(header.keyLength, '\0');
+		if (fread(&entryKey[0], 1, entryKey.size(), file) == entryKey.size() && entryKey == key)
+		{
+			size_t size = (size_t)header.width * header.height * 4;
+
+			data = new unsigned char[size];
+			if (fread(data, 1, size, file) != size)
+			{
+				delete[] data;
+				data = nullptr;
+			}
+		}
+	}
+
+	fclose(file);
+
+	if (data == nullptr)
+		return nullptr;
+
+	// The garbage collector removes the entries by modification time, a hit makes this one the most recently used
+	Utils::FileSystem::touchFile(entryPath);
+
+	info.width = header.width;
+	info.height = header.height;
+	info.baseSize = Vector2i(header.baseWidth, header.baseHeight);
+	info.packedSize = Vector2i(header.packedWidth, header.packedHeight);
+	info.sourceSize = Vector2f(header.sourceWidth, header.sourceHeight);
+
+	return data;
+}
+
+void ThumbnailCache::save(const std::string& path, const std::string& variant, const unsigned char* data, const ThumbnailInfo& info)
+{
+	size_t size = info.width * info.height * 4;
+	if (data == nullptr || size == 0 || size > THUMBNAIL_CACHE_MAX_ENTRY)
+		return;
+
+	long long mtime = Utils::FileSystem::getModificationTime(path);
+	if (mtime == 0)
+		return;
+
+	std::string key = getKey(path, mtime, variant);
+
+	ThumbnailHeader header;
+	memcpy(header.magic, THUMBNAIL_CACHE_MAGIC, 4);
+	header.version = THUMBNAIL_CACHE_VERSION;
+	header.width = (uint32_t)info.width;
+	header.height = (uint32_t)info.height;
+	header.baseWidth = (uint32_t)info.baseSize.x();
+	header.baseHeight = (uint32_t)info.baseSize.y();
+	header.packedWidth = (uint32_t)info.packedSize.x();
+	header.packedHeight = (uint32_t)info.packedSize.y();
+	header.sourceWidth = info.sourceSize.x();
+	header.sourceHeight = info.sourceSize.y();
+	header.keyLength = (uint32_t)key.size();
+
+	std::string entry;
+	entry.reserve(sizeof(header) + key.size() + size);
+	entry.append((const char*)&header, sizeof(header));
+	entry.append(key);
+	entry.append((const char*)data, size);
+
+	std::string cachePath = getCachePath();
+	if (!Utils::FileSystem::exists(cachePath))
+		Utils::FileSystem::createDirectory(cachePath);
+
+	std::string entryPath = getEntryPath(key);
+	size_t previousSize = Utils::FileSystem::getFileSize(entryPath); // 0 if it's a new entry
+
+	if (!PersistenceManager::writeFile(entryPath, entry))
+		return;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	long long maxSizeBytes = (long long)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+
+	// The first write scans the directory to know how big the cache is
+	if (mTotalSize >= 0)
+		mTotalSize += (long long)entry.size() - (long long)previousSize;
+
+	if ((mTotalSize < 0 || mTotalSize > maxSizeBytes) && !mCollecting)
+	{
+		mCollecting = true;
+		mTasks.run([this] { collectGarbage(); });
+	}
+}
+
+void ThumbnailCache::collectGarbage()
+{
+	struct CacheFile
+	{
+		std::string	path;
+		long long	mtime;
+		size_t		size;
+	};
+
+	std::vector<CacheFile> files;
+	long long total = 0;
+	int orphans = 0;
+
+	long long tmpMaxTime = ((long long)time(nullptr) - THUMBNAIL_CACHE_TMP_MAX_AGE) * 1000000000LL;
+
+	std::string cachePath = getCachePath();
+	Utils::FileSystem::stringList content = Utils::FileSystem::getDirContent(cachePath);
+	for (auto it = content.cbegin(); it != content.cend(); ++it)
+	{
+		// "<hash>.rgba.tmp" files are being written, or were left by an interrupted write
+		if (Utils::FileSystem::getExtension(*it) == ".tmp")
+		{
+			if (Utils::FileSystem::getExtension(Utils::FileSystem::getStem(*it)) == THUMBNAIL_CACHE_EXTENSION &&
+				Utils::FileSystem::getModificationTime(*it) < tmpMaxTime && Utils::FileSystem::removeFile(*it))
+				orphans++;
+
+			continue;
+		}
+
+		if (Utils::FileSystem::getExtension(*it) != THUMBNAIL_CACHE_EXTENSION)
+			continue;
+
+		CacheFile file;
+		file.path = *it;
+		file.mtime = Utils::FileSystem::getModificationTime(*it);
+		file.size = Utils::FileSystem::getFileSize(*it);
+
+		files.push_back(file);
+		total += file.size;
+	}
+
+	long long maxSizeBytes = (long long)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+
+	if (total > maxSizeBytes)
+	{
+		// Remove the least recently used entries, down to 3/4 of the limit so this does not run again at the next write
+		std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.mtime < b.mtime; });
+
+		long long target = maxSizeBytes / 4 * 3;
+		int removed = 0;
+
+		for (auto it = files.cbegin(); it != files.cend() && total > target; ++it)
+		{
+			if (Utils::FileSystem::removeFile(it->path))
+			{
+				total -= it->size;
+				removed++;
+			}
+		}
+
+		LOG(LogInfo) << "ThumbnailCache : " << removed << " entries removed, " << (total / 1024 / 1024) << " MB left";
+	}
+
+	if (orphans > 0)
+		LOG(LogInfo) << "ThumbnailCache : " << orphans << " interrupted writes removed";
+
+	std::unique_lock<std::mutex> lock(mLock);
+	mTotalSize = total;
+	mCollecting = false;
+}
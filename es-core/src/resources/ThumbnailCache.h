@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include "math/Vector2f.h"
+#include "math/Vector2i.h"
+#include "utils/TaskScheduler.h"
+#include <mutex>
+#include <string>
+
+// What TextureData needs to know about a cached image besides its pixels
+struct ThumbnailInfo
+{
+	size_t		width;
+	size_t		height;
+	Vector2i	baseSize;
+	Vector2i	packedSize;
+	Vector2f	sourceSize;
+};
+
+// Keeps decoded images on disk, already resized to the size they are displayed at.
+//
+// Entries are raw RGBA files in ~/.emulationstation/cache/thumbnails, keyed by the source path, its modification
+// time and a variant describing the decoding parameters (target size...) : a cached image is read back with a single
+// read, without decoding or rescaling. When the cache grows over ThumbnailCacheSize MB, the least recently used
+// entries are removed in the background : a hit updates the entry modification time.
+class ThumbnailCache
+{
+public:
+	static ThumbnailCache* getInstance();
+
+	static bool isEnabled();
+	static std::string getCachePath();
+
+	// Returns the pixels (new[] RGBA, as they were saved) or nullptr if the entry is missing or outdated. Thread safe.
+	unsigned char* load(const std::string& path, const std::string& variant, ThumbnailInfo& info);
+
+	// Stores info.width x info.height RGBA pixels. path must be a file on disk. Thread safe.
+	void save(const std::string& path, const std::string& variant, const unsigned char* data, const ThumbnailInfo& info);
+
+private:
+	ThumbnailCache();
+
+	static std::string getKey(const std::string& path, long long mtime, const std::string& variant);
+	static std::string getEntryPath(const std::string& key);
+
+	void collectGarbage();
+
+	std::mutex			mLock;
+	long long			mTotalSize;	// bytes, -1 until the cache directory has been scanned
+	bool				mCollecting;
+	Utils::TaskGroup	mTasks;
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
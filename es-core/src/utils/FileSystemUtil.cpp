@@ -13,16 +13,20 @@
 #include <direct.h>
 #include <Windows.h>
 #include <mutex>
+#include <sys/utime.h>
 #define getcwd _getcwd
 #define mkdir(x,y) _mkdir(x)
 #define snprintf _snprintf
 #define stat64 _stat64
 #define unlink _unlink
+#define utime _utime
 #define S_ISREG(x) (((x) & S_IFMT) == S_IFREG)
 #define S_ISDIR(x) (((x) & S_IFMT) == S_IFDIR)
 #else // _WIN32
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <utime.h>
 #endif // _WIN32
 #include <fstream>
 
@@ -62,10 +66,10 @@ namespace Utils
 			std::string path = getGenericPath(_path);
 			fileList  contentList;
 
+#if defined(_WIN32)
 			// only parse the directory, if it's a directory
 			if (isDirectory(path))
 			{
-#if defined(_WIN32)
 				std::unique_lock<std::mutex> lock(mFileMutex);
 
 				WIN32_FIND_DATAW findData;
@@ -86,42 +90,65 @@ namespace Utils
 						fi.path = path + "/" + name;
 						fi.hidden = (findData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) == FILE_ATTRIBUTE_HIDDEN;
 						fi.directory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
+						fi.symlink = (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == FILE_ATTRIBUTE_REPARSE_POINT;
 						contentList.push_back(fi);			
 					} 
 					while (FindNextFileW(hFind, &findData));
 
 					FindClose(hFind);
 				}
+			}
 #else // _WIN32
-				DIR* dir = opendir(path.c_str());
+			// opendir fails by itself if it's not a directory
+			DIR* dir = opendir(path.c_str());
+
+			if (dir != NULL)
+			{
+				int dirFd = dirfd(dir);
+				struct dirent* entry;
 
-				if (dir != NULL)
+				// loop over all files in the directory
+				while ((entry = readdir(dir)) != NULL)
 				{
-					struct dirent* entry;
+					const char* name = entry->d_name;
 
-					// loop over all files in the directory
-					while ((entry = readdir(dir)) != NULL)
-					{
-						std::string name(entry->d_name);
+					// ignore "." and ".."
+					if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+						continue;
 
-						// ignore "." and ".."
-						if ((name != ".") && (name != ".."))
-						{
-							std::string fullName(getGenericPath(path + "/" + name));
+					FileInfo fi;
+					fi.path = path + "/" + name; // path is already generic, and a name can't contain '/'
+					fi.hidden = (name[0] == '.');
+					fi.directory = false;
+					fi.symlink = false;
 
-							FileInfo fi;
-							fi.path = fullName;
-							fi.hidden = Utils::FileSystem::isHidden(fullName);
-							fi.directory = isDirectory(fullName);
-							contentList.push_back(fi);
-						}
+					// the entry type usually comes with readdir, only stat symlinks & file systems that don't fill it
+					unsigned char type = DT_UNKNOWN;
+#ifdef _DIRENT_HAVE_D_TYPE
+					type = entry->d_type;
+#endif
+					if (type == DT_UNKNOWN)
+					{
+						struct stat info;
+						if (fstatat(dirFd, name, &info, AT_SYMLINK_NOFOLLOW) == 0)
+							type = S_ISLNK(info.st_mode) ? DT_LNK : (S_ISDIR(info.st_mode) ? DT_DIR : DT_REG);
 					}
 
-					closedir(dir);
+					if (type == DT_LNK)
+					{
+						struct stat info;
+						fi.symlink = true;
+						fi.directory = (fstatat(dirFd, name, &info, 0) == 0 && S_ISDIR(info.st_mode));
+					}
+					else
+						fi.directory = (type == DT_DIR);
+
+					contentList.push_back(fi);
 				}
-#endif // _WIN32
 
+				closedir(dir);
 			}
+#endif // _WIN32
 
 			// sort the content list
 			// Why loose time -> It will be sorted later ????		contentList.sort(compareFileInfo);
@@ -732,6 +759,33 @@ namespace Utils
 			return 0;
 		}
 
+		long long getModificationTime(const std::string& _path)
+		{
+			std::string path = getGenericPath(_path);
+			struct stat64 info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return 0;
+
+			// nanosecond resolution where available, a directory touched twice within a second must still look changed
+#if defined(__linux__)
+			return ((long long)info.st_mtim.tv_sec * 1000000000LL) + info.st_mtim.tv_nsec;
+#else // __linux__
+			return (long long)info.st_mtime * 1000000000LL;
+#endif // __linux__
+
+		} // getModificationTime
+
+		bool touchFile(const std::string& _path)
+		{
+			std::string path = getGenericPath(_path);
+
+			// sets the access and modification times to now
+			return (utime(path.c_str(), nullptr) == 0);
+
+		} // touchFile
+
 		bool isAbsolute(const std::string& _path)
 		{
 			std::string path = getGenericPath(_path);
@@ -36,6 +36,8 @@ namespace Utils
 		bool        createDirectory    (const std::string& _path);
 		bool        exists             (const std::string& _path);
 		size_t		getFileSize(const std::string& _path);
+		long long	getModificationTime(const std::string& _path);
+		bool		touchFile(const std::string& _path);
 		bool        isAbsolute         (const std::string& _path);
 		bool        isRegularFile      (const std::string& _path);
 		bool        isDirectory        (const std::string& _path);
@@ -48,11 +50,13 @@ namespace Utils
 		public:
 			std::string path;
 			bool hidden;
-			bool directory;
+			bool directory; // symlinks are followed
+			bool symlink;
 		};
 
 		typedef std::list<FileInfo> fileList;
 
+		// Lists a directory without stat'ing its entries when the file system gives their type
 		fileList  getDirInfo(const std::string& _path/*, const bool _recursive = false*/);
 
 		void		writeAllText	   (const std::string fileName, const std::string text);
@@ -0,0 +1,162 @@
+#include "utils/PixelUtil.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXEL_UTIL_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_UTIL_NEON
+#endif
+
+namespace Utils
+{
+	namespace Pixel
+	{
+		void swapRedBlue(const unsigned char* _src, unsigned char* _dst, const size_t _count)
+		{
+			size_t i = 0;
+
+#if defined(PIXEL_UTIL_SSE2)
+			// 4 pixels at a time : keep A and G, exchange the bytes 0 and 2 of every pixel with 16 bit shifts
+			const __m128i maskAG = _mm_set1_epi32((int)0xFF00FF00);
+			const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+
+			for (; i + 4 <= _count; i += 4)
+			{
+				__m128i c  = _mm_loadu_si128((const __m128i*)(_src + i * 4));
+				__m128i ag = _mm_and_si128(c, maskAG);
+				__m128i rb = _mm_and_si128(c, maskRB);
+				rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+				_mm_storeu_si128((__m128i*)(_dst + i * 4), _mm_or_si128(ag, rb));
+			}
+#elif defined(PIXEL_UTIL_NEON)
+			// 16 pixels at a time, deinterleaved by channel
+			for (; i + 16 <= _count; i += 16)
+			{
+				uint8x16x4_t c = vld4q_u8(_src + i * 4);
+				uint8x16_t   r = c.val[0];
+				c.val[0] = c.val[2];
+				c.val[2] = r;
+				vst4q_u8(_dst + i * 4, c);
+			}
+#endif
+
+			for (; i < _count; i++)
+			{
+				uint32_t c;
+				memcpy(&c, _src + i * 4, 4);
+				c = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+				memcpy(_dst + i * 4, &c, 4);
+			}
+
+		} // swapRedBlue
+
+		void flipVertical(unsigned char* _pixels, const size_t _width, const size_t _height)
+		{
+			const size_t rowSize = _width * 4;
+
+			// Whole rows are exchanged, the copies are vectorized by the C library
+			std::vector<unsigned char> temp(rowSize);
+
+			for (size_t y = 0; y < _height / 2; y++)
+			{
+				unsigned char* top    = _pixels + y * rowSize;
+				unsigned char* bottom = _pixels + (_height - y - 1) * rowSize;
+
+				memcpy(temp.data(), top, rowSize);
+				memcpy(top, bottom, rowSize);
+				memcpy(bottom, temp.data(), rowSize);
+			}
+
+		} // flipVertical
+
+		void downscaleBox(const unsigned char* _src, const size_t _srcWidth, const size_t _srcHeight, const size_t _srcStride, unsigned char* _dst, const size_t _dstWidth, const size_t _dstHeight)
+		{
+			if (_dstWidth == 0 || _dstHeight == 0 || _srcWidth < _dstWidth || _srcHeight < _dstHeight)
+				return;
+
+			// Source columns covered by every destination column
+			std::vector<size_t> columns(_dstWidth + 1);
+			for (size_t x = 0; x <= _dstWidth; x++)
+				columns[x] = x * _srcWidth / _dstWidth;
+
+			// Channel sums of the source rows covered by the current destination row
+			std::vector<uint32_t> sums(_srcWidth * 4);
+
+			for (size_t y = 0; y < _dstHeight; y++)
+			{
+				const size_t firstRow = y * _srcHeight / _dstHeight;
+				const size_t lastRow  = (y + 1) * _srcHeight / _dstHeight;
+
+				memset(sums.data(), 0, sums.size() * sizeof(uint32_t));
+
+				for (size_t row = firstRow; row < lastRow; row++)
+				{
+					const unsigned char* line = _src + row * _srcStride;
+					uint32_t*            sum  = sums.data();
+					size_t               i    = 0;
+
+#if defined(PIXEL_UTIL_SSE2)
+					const __m128i zero = _mm_setzero_si128();
+
+					for (; i + 16 <= _srcWidth * 4; i += 16)
+					{
+						__m128i c  = _mm_loadu_si128((const __m128i*)(line + i));
+						__m128i lo = _mm_unpacklo_epi8(c, zero);
+						__m128i hi = _mm_unpackhi_epi8(c, zero);
+
+						__m128i* s = (__m128i*)(sum + i);
+						_mm_storeu_si128(s + 0, _mm_add_epi32(_mm_loadu_si128(s + 0), _mm_unpacklo_epi16(lo, zero)));
+						_mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+						_mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+						_mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+					}
+#elif defined(PIXEL_UTIL_NEON)
+					for (; i + 16 <= _srcWidth * 4; i += 16)
+					{
+						uint8x16_t c  = vld1q_u8(line + i);
+						uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+						uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+
+						vst1q_u32(sum + i +  0, vaddw_u16(vld1q_u32(sum + i +  0), vget_low_u16(lo)));
+						vst1q_u32(sum + i +  4, vaddw_u16(vld1q_u32(sum + i +  4), vget_high_u16(lo)));
+						vst1q_u32(sum + i +  8, vaddw_u16(vld1q_u32(sum + i +  8), vget_low_u16(hi)));
+						vst1q_u32(sum + i + 12, vaddw_u16(vld1q_u32(sum + i + 12), vget_high_u16(hi)));
+					}
+#endif
+
+					for (; i < _srcWidth * 4; i++)
+						sum[i] += line[i];
+				}
+
+				const uint32_t rows = (uint32_t)(lastRow - firstRow);
+				unsigned char* out  = _dst + y * _dstWidth * 4;
+
+				for (size_t x = 0; x < _dstWidth; x++)
+				{
+					const uint32_t count = rows * (uint32_t)(columns[x + 1] - columns[x]);
+					uint32_t       total[4] = { 0, 0, 0, 0 };
+
+					for (size_t column = columns[x]; column < columns[x + 1]; column++)
+					{
+						const uint32_t* sum = sums.data() + column * 4;
+						total[0] += sum[0];
+						total[1] += sum[1];
+						total[2] += sum[2];
+						total[3] += sum[3];
+					}
+
+					for (int c = 0; c < 4; c++)
+						out[x * 4 + c] = (unsigned char)((total[c] + count / 2) / count);
+				}
+			}
+
+		} // downscaleBox
+
+	} // Pixel::
+
+} // Utils::
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef ES_CORE_UTILS_PIXEL_UTIL_H
+#define ES_CORE_UTILS_PIXEL_UTIL_H
+
+#include <stddef.h>
+
+// Pixel kernels on 32 bit pixels, vectorized with SSE2 or NEON when the target has it
+namespace Utils
+{
+	namespace Pixel
+	{
+		// Swaps the red and blue channels of _count pixels, _src and _dst may be the same buffer
+		void swapRedBlue        (const unsigned char* _src, unsigned char* _dst, const size_t _count);
+		// Reverses the row order of an image, in place
+		void flipVertical       (unsigned char* _pixels, const size_t _width, const size_t _height);
+		// Area averaging downscale, channel order doesn't matter. Strides are in bytes.
+		void downscaleBox       (const unsigned char* _src, const size_t _srcWidth, const size_t _srcHeight, const size_t _srcStride, unsigned char* _dst, const size_t _dstWidth, const size_t _dstHeight);
+
+	} // Pixel::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_PIXEL_UTIL_H
@@ -0,0 +1,62 @@
+#include "utils/StringPool.h"
+
+#include <sstream>
+
+namespace Utils
+{
+	StringPool* StringPool::getInstance()
+	{
+		static StringPool* sInstance = new StringPool();
+		return sInstance;
+	}
+
+	StringPool::StringPool() : mStoredBytes(0), mReferences(0), mSavedBytes(0)
+	{
+		mEmpty = intern("");
+	}
+
+	size_t StringPool::getStringSize(const std::string& value)
+	{
+		// Short strings fit in the object itself
+		return sizeof(std::string) + (value.capacity() > 15 ? value.capacity() + 1 : 0);
+	}
+
+	const std::string* StringPool::intern(const std::string& value)
+	{
+		Shard& shard = mShards[std::hash<std::string>()(value) % STRING_POOL_SHARDS];
+
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		auto result = shard.strings.insert(value);
+		if (result.second)
+			mStoredBytes += getStringSize(*result.first);
+		else
+		{
+			mReferences++;
+			mSavedBytes += getStringSize(value);
+		}
+
+		return &(*result.first);
+	}
+
+	std::string StringPool::getReport()
+	{
+		size_t strings = 0;
+		size_t storedBytes = mStoredBytes;
+
+		for (auto& shard : mShards)
+		{
+			std::unique_lock<std::mutex> lock(shard.lock);
+			strings += shard.strings.size();
+			// hash nodes and buckets
+			storedBytes += shard.strings.size() * (sizeof(void*) + sizeof(size_t)) + shard.strings.bucket_count() * sizeof(void*);
+		}
+
+		std::stringstream ss;
+		ss << "StringPool : " << strings << " strings, " << (storedBytes / 1024) << " KB stored, " <<
+			mReferences << " shared references saving " << (mSavedBytes / 1024) << " KB";
+
+		return ss.str();
+	}
+
+} // Utils::
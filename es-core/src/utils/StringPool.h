@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_CORE_UTILS_STRING_POOL_H
+#define ES_CORE_UTILS_STRING_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+// Separately locked parts of the pool, so threads loading gamelists rarely wait for each other
+#define STRING_POOL_SHARDS 16
+
+namespace Utils
+{
+	// Process-wide set of immutable strings : metadata values repeated across a library (developers, genres, ratings...)
+	// are stored once and referenced by pointer. Equal strings get the same pointer, so interned strings can be compared
+	// by address. Strings are never released, the pointers stay valid until exit.
+	class StringPool
+	{
+	public:
+		// The instance is never destroyed : lists may still be copied while static objects are destroyed
+		static StringPool* getInstance();
+
+		const std::string* intern(const std::string& value);
+		const std::string* getEmpty() const { return mEmpty; }
+
+		// Strings stored, memory used, and memory saved by the references to existing strings
+		std::string getReport();
+
+	private:
+		StringPool();
+
+		// Heap memory of a separate copy of the string
+		static size_t getStringSize(const std::string& value);
+
+		struct Shard
+		{
+			std::mutex						lock;
+			std::unordered_set<std::string>	strings;
+		};
+
+		Shard					mShards[STRING_POOL_SHARDS];
+		const std::string*		mEmpty;
+
+		std::atomic<size_t>		mStoredBytes;
+		std::atomic<size_t>		mReferences;	// intern calls returning an existing string
+		std::atomic<size_t>		mSavedBytes;
+	};
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_STRING_POOL_H
@@ -170,6 +170,58 @@ namespace Utils
 #endif
 		} // toUpper
 
+		std::string foldForSearch(const std::string& _string)
+		{
+			// Uppercased base letters of U+00C0 to U+017F, '*' keeps the character
+			static const char* latin1         = "AAAAAA*CEEEEIIIIDNOOOOO*OUUUUY**AAAAAA*CEEEEIIIIDNOOOOO*OUUUUY*Y";
+			static const char* latinExtendedA = "AAAAAACCCCCCCCDDDDEEEEEEEEEEGGGGGGGGHHHHIIIIIIIIIIIIJJKKKLLLLLLLLLLNNNNNNNNNOOOOOOOORRRRRRSSSSSSSSTTTTTTUUUUUUUUUUUUWWYYYZZZZZZS";
+
+			std::string string;
+			string.reserve(_string.length());
+
+			size_t cursor = 0;
+			while(cursor < _string.length())
+			{
+				const unsigned char c = (unsigned char)_string[cursor];
+
+				if(c < 0x80)
+				{
+					string += (char)toupper(c);
+					++cursor;
+					continue;
+				}
+
+				// chars2Unicode reads past the end of truncated sequences
+				const size_t start  = cursor;
+				const size_t length = ((c & 0xE0) == 0xC0) ? 2 : ((c & 0xF0) == 0xE0) ? 3 : ((c & 0xF8) == 0xF0) ? 4 : 1;
+				if((start + length) > _string.length())
+				{
+					string.append(_string, start, std::string::npos);
+					break;
+				}
+
+				const unsigned int unicode = chars2Unicode(_string, cursor);
+
+				if((unicode == 0xC6) || (unicode == 0xE6))
+					string += "AE";
+				else if(unicode == 0xDF)
+					string += "SS";
+				else if((unicode == 0x152) || (unicode == 0x153))
+					string += "OE";
+				else if((unicode == 0x132) || (unicode == 0x133))
+					string += "IJ";
+				else if((unicode >= 0xC0) && (unicode <= 0xFF) && (latin1[unicode - 0xC0] != '*'))
+					string += latin1[unicode - 0xC0];
+				else if((unicode >= 0x100) && (unicode <= 0x17F))
+					string += latinExtendedA[unicode - 0x100];
+				else
+					string.append(_string, start, cursor - start);
+			}
+
+			return string;
+
+		} // foldForSearch
+
 		std::string trim(const std::string& _string)
 		{
 			const size_t strBegin = _string.find_first_not_of(" \t");
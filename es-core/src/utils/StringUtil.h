@@ -18,6 +18,7 @@ namespace Utils
 		size_t       moveCursor         (const std::string& _string, const size_t _cursor, const int _amount);
 		std::string  toLower            (const std::string& _string);
 		std::string  toUpper            (const std::string& _string);
+		std::string  foldForSearch      (const std::string& _string);
 		std::string  trim               (const std::string& _string);
 		std::string  replace            (const std::string& _string, const std::string& _replace, const std::string& _with);
 		bool         startsWith         (const std::string& _string, const std::string& _start);
@@ -0,0 +1,315 @@
+#include "utils/TaskScheduler.h"
+
+#include "Log.h"
+
+namespace Utils
+{
+	// index of the worker running on this thread, -1 for any other thread
+	static thread_local int sWorkerIndex = -1;
+
+	TaskScheduler* TaskScheduler::getInstance()
+	{
+		static TaskScheduler* sInstance = new TaskScheduler();
+		return sInstance;
+
+	} // getInstance
+
+	TaskScheduler::TaskScheduler() : mPending(0)
+	{
+		// leave a core to the main thread
+		unsigned int count = std::thread::hardware_concurrency();
+		count = (count > 1) ? count - 1 : 1;
+
+		for (unsigned int i = 0; i < count; i++)
+			mWorkers.push_back(new Worker());
+
+		// start the threads once every deque exists, they steal from each other
+		for (unsigned int i = 0; i < count; i++)
+			mWorkers[i]->thread = std::thread(&TaskScheduler::workerProc, this, (int)i);
+
+	} // TaskScheduler
+
+	bool TaskScheduler::isWorkerThread()
+	{
+		return sWorkerIndex >= 0;
+
+	} // isWorkerThread
+
+	void TaskScheduler::schedule(Task task)
+	{
+		int self = sWorkerIndex;
+		if (self >= 0)
+		{
+			std::unique_lock<std::mutex> lock(mWorkers[self]->lock);
+			mWorkers[self]->tasks.push_back(std::move(task));
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(mSharedLock);
+			mSharedTasks.push_back(std::move(task));
+		}
+
+		mPending++;
+
+		// a worker checks mPending with mSleepLock held before sleeping, taking it here means the notify can't be missed
+		{
+			std::unique_lock<std::mutex> lock(mSleepLock);
+		}
+
+		mWakeUp.notify_one();
+
+	} // schedule
+
+	bool TaskScheduler::popTask(int self, Task& task)
+	{
+		if (mPending.load() <= 0)
+			return false;
+
+		// newest task of our own deque first
+		if (self >= 0)
+		{
+			Worker* worker = mWorkers[self];
+
+			std::unique_lock<std::mutex> lock(worker->lock);
+			if (!worker->tasks.empty())
+			{
+				task = std::move(worker->tasks.back());
+				worker->tasks.pop_back();
+				mPending--;
+				return true;
+			}
+		}
+
+		// then the tasks queued from outside the pool, in order
+		{
+			std::unique_lock<std::mutex> lock(mSharedLock);
+			if (!mSharedTasks.empty())
+			{
+				task = std::move(mSharedTasks.front());
+				mSharedTasks.pop_front();
+				mPending--;
+				return true;
+			}
+		}
+
+		// finally steal the oldest task of another worker
+		int count = (int)mWorkers.size();
+		for (int i = 1; i <= count; i++)
+		{
+			int victim = (self + i) % count;
+			if (victim == self)
+				continue;
+
+			Worker* worker = mWorkers[victim];
+
+			std::unique_lock<std::mutex> lock(worker->lock);
+			if (!worker->tasks.empty())
+			{
+				task = std::move(worker->tasks.front());
+				worker->tasks.pop_front();
+				mPending--;
+				return true;
+			}
+		}
+
+		return false;
+
+	} // popTask
+
+	void TaskScheduler::runTask(Task& task)
+	{
+		try
+		{
+			task();
+		}
+		catch (std::exception& e)
+		{
+			LOG(LogError) << "TaskScheduler : task failed, " << e.what();
+		}
+		catch (...)
+		{
+			LOG(LogError) << "TaskScheduler : task failed";
+		}
+
+		task = nullptr;
+
+	} // runTask
+
+	void TaskScheduler::workerProc(int index)
+	{
+		sWorkerIndex = index;
+
+		Task task;
+
+		while (true)
+		{
+			if (popTask(index, task))
+			{
+				runTask(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mSleepLock);
+			mWakeUp.wait(lock, [this] { return mPending.load() > 0; });
+		}
+
+	} // workerProc
+
+	TaskGroup::TaskGroup() : mState(std::make_shared<State>())
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		wait();
+	}
+
+	void TaskGroup::run(TaskScheduler::Task task)
+	{
+		std::shared_ptr<State> state = mState;
+
+		{
+			std::unique_lock<std::mutex> lock(state->lock);
+			state->tasks.push_back(std::move(task));
+			state->pending++;
+		}
+
+		// one scheduled task per group task, it does nothing if a waiting thread already ran it
+		TaskScheduler::getInstance()->schedule([state] { runNext(*state); });
+
+	} // run
+
+	bool TaskGroup::runNext(State& state)
+	{
+		TaskScheduler::Task task;
+
+		{
+			std::unique_lock<std::mutex> lock(state.lock);
+			if (state.tasks.empty())
+				return false;
+
+			task = std::move(state.tasks.front());
+			state.tasks.pop_front();
+		}
+
+		try
+		{
+			task();
+		}
+		catch (std::exception& e)
+		{
+			LOG(LogError) << "TaskGroup : task failed, " << e.what();
+		}
+		catch (...)
+		{
+			LOG(LogError) << "TaskGroup : task failed";
+		}
+
+		task = nullptr;
+
+		std::unique_lock<std::mutex> lock(state.lock);
+		state.completed++;
+		if (--state.pending == 0)
+			state.done.notify_all();
+
+		return true;
+
+	} // runNext
+
+	void TaskGroup::wait()
+	{
+		// run the tasks of the group nobody started yet, then sleep until the running ones are done
+		while (runNext(*mState))
+			;
+
+		std::unique_lock<std::mutex> lock(mState->lock);
+		mState->done.wait(lock, [this] { return mState->pending.load() == 0; });
+
+	} // wait
+
+	bool TaskGroup::waitFor(int milliseconds)
+	{
+		std::unique_lock<std::mutex> lock(mState->lock);
+		return mState->done.wait_for(lock, std::chrono::milliseconds(milliseconds), [this] { return mState->pending.load() == 0; });
+
+	} // waitFor
+
+	namespace Detail
+	{
+		bool FutureStateBase::isReady()
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			return mReady;
+
+		} // isReady
+
+		void FutureStateBase::wait()
+		{
+			// run the awaited function here if it's still queued, a worker may be waiting on a task queued behind it.
+			// Other tasks of the pool are never picked, they could be long (a whole system load) or wait themselves.
+			runTask();
+
+			std::unique_lock<std::mutex> lock(mLock);
+			mCond.wait(lock, [this] { return mReady; });
+
+		} // wait
+
+		void FutureStateBase::setTask(TaskScheduler::Task task)
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			mTask = std::move(task);
+
+		} // setTask
+
+		bool FutureStateBase::runTask()
+		{
+			TaskScheduler::Task task;
+
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				if (!mTask)
+					return false;
+
+				task = std::move(mTask);
+				mTask = nullptr;
+			}
+
+			task();
+			return true;
+
+		} // runTask
+
+		void FutureStateBase::setReady()
+		{
+			std::vector<TaskScheduler::Task> continuations;
+
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				mReady = true;
+				continuations.swap(mContinuations);
+				mCond.notify_all();
+			}
+
+			for (auto& continuation : continuations)
+				TaskScheduler::getInstance()->schedule(continuation);
+
+		} // setReady
+
+		void FutureStateBase::addContinuation(TaskScheduler::Task continuation)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				if (!mReady)
+				{
+					mContinuations.push_back(continuation);
+					return;
+				}
+			}
+
+			TaskScheduler::getInstance()->schedule(continuation);
+
+		} // addContinuation
+
+	} // Detail::
+
+} // Utils::
@@ -0,0 +1,228 @@
+#pragma once
+#ifndef ES_CORE_UTILS_TASK_SCHEDULER_H
+#define ES_CORE_UTILS_TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+	template<typename T> class Future;
+
+	// Pool of worker threads shared by the whole application : system loading, gamelist parsing, sorting, texture decoding...
+	//
+	// Every worker owns a deque. A task queued from a worker goes at the back of the worker's own deque and is taken
+	// back from there, so nested work stays hot in cache. Tasks queued from any other thread go to a shared queue.
+	// A worker with an empty deque takes from the shared queue, then steals from the front of the other deques.
+	// Workers with nothing to do sleep on a condition variable.
+	class TaskScheduler
+	{
+	public:
+		typedef std::function<void(void)> Task;
+
+		// The instance is never destroyed : textures may still be decoding while static objects are destroyed
+		static TaskScheduler* getInstance();
+
+		void schedule(Task task);
+
+		// Runs the returned future's function on a worker
+		template<typename F> auto async(F func) -> Future<decltype(func())>;
+
+		size_t getWorkerCount() const { return mWorkers.size(); }
+		static bool isWorkerThread();
+
+	private:
+		TaskScheduler();
+
+		struct Worker
+		{
+			std::mutex			lock;
+			std::deque<Task>	tasks;
+			std::thread			thread;
+		};
+
+		bool popTask(int self, Task& task);
+		void runTask(Task& task);
+		void workerProc(int index);
+
+		std::vector<Worker*>	mWorkers;
+
+		std::mutex				mSharedLock;
+		std::deque<Task>		mSharedTasks;
+
+		std::mutex				mSleepLock;
+		std::condition_variable	mWakeUp;
+		std::atomic<int>		mPending; // queued, not started yet
+	};
+
+	// Set of tasks that can be waited for together. The counters are safe to read from any thread.
+	//
+	// The tasks are queued in the group, every task scheduled on the pool runs the oldest one not started yet. A waiting
+	// thread takes them from the same queue, so it never picks an unrelated, possibly long, task of the pool.
+	class TaskGroup
+	{
+	public:
+		TaskGroup();
+		~TaskGroup();
+
+		void run(TaskScheduler::Task task);
+
+		// Waits for all the tasks of the group, running the ones not started yet on the calling thread meanwhile
+		void wait();
+
+		// Sleeps until all the tasks of the group are done or the delay expires, returns true if they are done.
+		// Nothing runs on the calling thread, the main loop uses it to keep the loading screen alive.
+		bool waitFor(int milliseconds);
+
+		int getPendingCount() const { return mState->pending.load(); }
+		int getCompletedCount() const { return mState->completed.load(); }
+
+	private:
+		// Shared with the scheduled tasks : the group can be destroyed while some of them, finding nothing left to run, are still queued
+		struct State
+		{
+			State() : pending(0), completed(0) { }
+
+			std::atomic<int>					pending;	// queued or running
+			std::atomic<int>					completed;
+			std::mutex							lock;
+			std::condition_variable				done;
+			std::deque<TaskScheduler::Task>		tasks;		// not started yet
+		};
+
+		// Runs the oldest task of the group not started yet, returns false if there was none
+		static bool runNext(State& state);
+
+		std::shared_ptr<State>	mState;
+	};
+
+	namespace Detail
+	{
+		class FutureStateBase
+		{
+		public:
+			FutureStateBase() : mReady(false) { }
+
+			bool isReady();
+			void wait();
+			void setReady();
+
+			// Function computing the state, run by whichever comes first of the scheduled task and a waiting thread
+			void setTask(TaskScheduler::Task task);
+			// Runs the function if nobody started it yet, returns false otherwise
+			bool runTask();
+
+			// The continuation is scheduled as soon as the state is ready
+			void addContinuation(TaskScheduler::Task continuation);
+
+			std::exception_ptr mError;
+
+		private:
+			std::mutex						mLock;
+			std::condition_variable			mCond;
+			bool							mReady;
+			TaskScheduler::Task				mTask;	// not started yet
+			std::vector<TaskScheduler::Task> mContinuations;
+		};
+
+		template<typename T> class FutureState : public FutureStateBase
+		{
+		public:
+			T mValue;
+		};
+
+		template<> class FutureState<void> : public FutureStateBase
+		{
+		};
+
+		template<typename T, typename F> void invoke(FutureState<T>& state, F& func) { state.mValue = func(); }
+		template<typename F> void invoke(FutureState<void>& state, F& func) { func(); }
+
+		template<typename T> const T& getValue(FutureState<T>& state) { return state.mValue; }
+		inline void getValue(FutureState<void>& state) { }
+
+		template<typename T, typename F> void complete(FutureState<T>& state, F& func)
+		{
+			try
+			{
+				invoke(state, func);
+			}
+			catch (...)
+			{
+				state.mError = std::current_exception();
+			}
+
+			state.setReady();
+		}
+	}
+
+	// Result of a task scheduled with TaskScheduler::async
+	template<typename T>
+	class Future
+	{
+	public:
+		Future() { }
+		Future(std::shared_ptr<Detail::FutureState<T>> state) : mState(state) { }
+
+		bool valid() const { return mState != nullptr; }
+		bool isReady() const { return mState->isReady(); }
+		void wait() const { mState->wait(); }
+
+		// Waits for the result, rethrows the exception thrown by the task if any
+		auto get() const -> decltype(Detail::getValue(std::declval<Detail::FutureState<T>&>()))
+		{
+			mState->wait();
+			if (mState->mError)
+				std::rethrow_exception(mState->mError);
+
+			return Detail::getValue(*mState);
+		}
+
+		// Schedules func(*this) once this future is ready
+		template<typename F> auto then(F func) const -> Future<decltype(func(std::declval<Future<T>>()))>
+		{
+			typedef decltype(func(std::declval<Future<T>>())) R;
+
+			auto next = std::make_shared<Detail::FutureState<R>>();
+			Future<T> self = *this;
+
+			mState->addContinuation([self, next, func]() mutable
+			{
+				auto call = [&self, &func]() { return func(self); };
+				Detail::complete(*next, call);
+			});
+
+			return Future<R>(next);
+		}
+
+	private:
+		std::shared_ptr<Detail::FutureState<T>> mState;
+	};
+
+	template<typename F>
+	auto TaskScheduler::async(F func) -> Future<decltype(func())>
+	{
+		typedef decltype(func()) R;
+
+		auto state = std::make_shared<Detail::FutureState<R>>();
+
+		// the stored function doesn't own the state, the scheduled task does
+		Detail::FutureState<R>* target = state.get();
+		state->setTask([target, func]() mutable { Detail::complete(*target, func); });
+
+		schedule([state] { state->runTask(); });
+
+		return Future<R>(state);
+	}
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_TASK_SCHEDULER_H